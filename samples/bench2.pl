@@ -26,10 +26,18 @@ my @genType = ("SOG","SOP","SLAP",
 	       "FSEL -dR3","FSOWCTY -dR3",
 	       "SLAP-FST","SLAP-FSA");
 
+# the encodings and positions of the automaton in the fully symbolic product, selected with -m fsenc
+my @fsEncType = ("FSOWCTY --fs-encoding int --fs-tgba-pos top",
+		 "FSOWCTY --fs-encoding binary --fs-tgba-pos top",
+		 "FSOWCTY --fs-encoding onehot --fs-tgba-pos top",
+		 "FSOWCTY --fs-encoding int --fs-tgba-pos bottom",
+		 "FSOWCTY --fs-encoding binary --fs-tgba-pos bottom",
+		 "FSOWCTY --fs-encoding onehot --fs-tgba-pos bottom");
+
 my $DEFAULT_TIMEOUT = 120;
 # howto use this tool
 my $usage =
-    "Usage:\n bench.pl -m [generation method list = @genType all] -d [directory base]\n"
+    "Usage:\n bench.pl -m [generation method list = @genType all fsenc] -d [directory base]\n"
   . " bench.pl -m [generation method list = @genType all] -f [file.net]\n"
   . "example : ./bench.pl -m SOG,SOP -d test/\n"
   . "\n other options :\n"
@@ -67,13 +75,17 @@ if (defined $opt_q) {
 
 # parsing the methods
 my @methods = split /,/,$opt_m or  die "Specify a target method -m please ! \n$usage";
-my $gens = (join ' ',@genType)."all" ;
+my $gens = (join ' ',@genType,@fsEncType)."all fsenc" ;
 foreach my $m (@methods) {
   unless ($gens =~ /$m/) { die "Unknown method $m !\n $usage";}
   if ($m =~ /all/) {
     @methods = @genType;
     last;
   }
+  if ($m =~ /fsenc/) {
+    @methods = @fsEncType;
+    last;
+  }
 }
 
 use strict 'vars';   # After obtaining $opt_xxx, which is not a local variable
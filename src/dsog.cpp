@@ -63,6 +63,8 @@ namespace dsog
   }
 
   int dsog_div_state::compare(const state* other) const {
+    if (dynamic_cast<const dsog_init_state*>(other))
+      return 1;
     if (!dynamic_cast<const dsog_div_state*>(other))
       return -1;
     const dsog_div_state* m = dynamic_cast<const dsog_div_state*>(other);
@@ -89,6 +91,39 @@ namespace dsog
     return (os << "DSOGDivState " << std::endl);
   }
 
+  ////////////////////////////////////////////////////////////
+  // dsog_init_state
+
+  dsog_init_state::dsog_init_state(const std::vector<const dsog_state*> & inits)
+    : inits_(inits)
+  {
+  }
+
+  dsog_init_state::~dsog_init_state()
+  {
+    for (auto s : inits_)
+      s->destroy();
+  }
+
+  int dsog_init_state::compare(const state* other) const {
+    // there is a single artificial initial state
+    if (dynamic_cast<const dsog_init_state*>(other))
+      return 0;
+    return -1;
+  }
+
+  size_t dsog_init_state::hash() const {
+    return wang32_hash(inits_.size());
+  }
+
+  spot::state* dsog_init_state::clone() const {
+    std::vector<const dsog_state*> inits;
+    inits.reserve(inits_.size());
+    for (auto s : inits_)
+      inits.push_back(s->clone());
+    return new dsog_init_state(inits);
+  }
+
   ////////////////////////////////////////////////////////////
   // state_product
   dsog_state::dsog_state(const dsog_state& o)
@@ -118,7 +153,8 @@ namespace dsog
   int
   dsog_state::compare(const state* other) const
   {
-    if (dynamic_cast<const dsog_div_state*>(other))
+    if (dynamic_cast<const dsog_div_state*>(other)
+	|| dynamic_cast<const dsog_init_state*>(other))
       return 1;
     const dsog_state* o = dynamic_cast<const dsog_state*>(other);
     assert(o);
@@ -396,6 +432,41 @@ namespace dsog
   }
 
 
+  dsog_init_succ_iterator::dsog_init_succ_iterator(const dsog_init_state* s)
+    : s_(s), pos_(0)
+  {
+  }
+
+  bool dsog_init_succ_iterator::first() {
+    pos_ = 0;
+    return !done();
+  }
+
+  bool dsog_init_succ_iterator::next() {
+    ++pos_;
+    return !done();
+  }
+
+  bool dsog_init_succ_iterator::done() const {
+    return pos_ >= s_->get_inits().size();
+  }
+
+  spot::state* dsog_init_succ_iterator::dst() const {
+    assert(!done());
+    return s_->get_inits()[pos_]->clone();
+  }
+
+  bdd dsog_init_succ_iterator::cond() const {
+    assert(!done());
+    return s_->get_inits()[pos_]->get_cond();
+  }
+
+  spot::acc_cond::mark_t dsog_init_succ_iterator::acc() const {
+    assert(!done());
+    return {};
+  }
+
+
   ////////////////////////////////////////////////////////////
   // dsog_tgba
 
@@ -458,34 +529,29 @@ namespace dsog
     its::State m0 = model_.getInitialState() ;
     assert(m0 != its::State::null);
 
-    // now determine which AP are true in m0
-    sogits::APIterator* it = sogits::APIteratorFactory::create_new(vars);
-    for (it->first(); !it->done(); it->next() ) {
-      its::Transition selector = model_.getSelector(it->current());
-      its::State msel = selector(m0);
-      trace << "testing " << it->current() << std::endl;
-      if (msel != its::State::null) {
-	dsog_state *init = new dsog_state(lis, model_, m0, it->current());
-	trace << "Initial state of tgba :" << format_state(init)
-	      << "verifies :"<< it->current() << std::endl;
-	delete it;
-
-	return init;
-      }
-    }
+    // now determine which AP valuations occur in m0 (bddtrue if no AP expected)
+    std::vector<bdd> vals = model_.getValuations(m0, vars);
+    assert(!vals.empty());
 
-    // No AP expected.
-    if (vars.empty())
+    if (vals.size() == 1)
       {
-	dsog_state *init = new dsog_state(lis, model_, m0, bddtrue);
+	dsog_state *init = new dsog_state(lis, model_, m0, vals[0]);
+	trace << "Initial state of tgba :" << format_state(init)
+	      << "verifies :"<< vals[0] << std::endl;
 	assert(init->right() != its::State::null);
 	return init;
       }
 
-    assert(!"no conjunction of AP is verified by m0 ???");
-    // for compiler happiness
-    delete it;
-    return 0;
+    // m0 spans several valuations : one initial aggregate for each
+    std::vector<const dsog_state*> inits;
+    inits.reserve(vals.size());
+    for (const bdd & val : vals)
+      {
+	inits.push_back(new dsog_state(lis->clone(), model_, m0, val));
+	trace << "Initial aggregate verifies :"<< val << std::endl;
+      }
+    lis->destroy();
+    return new dsog_init_state(inits);
   }
 
   spot::twa_succ_iterator*
@@ -498,6 +564,10 @@ namespace dsog
 	return new dsog_div_succ_iterator(this, d->get_condition(), li);
       }
 
+    const dsog_init_state* i = dynamic_cast<const dsog_init_state*>(local_state);
+    if (i)
+      return new dsog_init_succ_iterator(i);
+
     const dsog_state* s =
       dynamic_cast<const dsog_state*>(local_state);
     assert(s);
@@ -521,6 +591,10 @@ namespace dsog
 		+ (s->get_div() ? " (div)" : "")
 		+ ss.str());
       }
+    else if (dynamic_cast<const dsog_init_state*>(state))
+      {
+	return "init_state";
+      }
     else
       {
 	const dsog_div_state* d = dynamic_cast<const dsog_div_state*>(state);
@@ -537,6 +611,8 @@ namespace dsog
   state*
   dsog_tgba::project_state(const state* s, const spot::const_twa_ptr& t) const
   {
+    if (dynamic_cast<const dsog_init_state*>(s))
+      return 0;
     const dsog_state* s2 = dynamic_cast<const dsog_state*>(s);
     assert(s2);
     if (t.get() == this)
@@ -55,6 +55,28 @@ namespace dsog
     bdd cond; ///< the condition.
   };
 
+  class dsog_state;
+
+  /// \brief An artificial initial state, used when the initial states of the
+  /// model span several valuations of the AP : its successors are the
+  /// initial aggregates, one per valuation.
+  class dsog_init_state final : public spot::state {
+  public:
+    /// The initial aggregates are owned by this state.
+    dsog_init_state(const std::vector<const dsog_state*> & inits);
+    ~dsog_init_state();
+    int compare(const state* other) const override;
+    size_t hash() const override;
+    state* clone() const override;
+    const std::vector<const dsog_state*> & get_inits() const { return inits_; }
+
+  private:
+    dsog_init_state(const dsog_init_state& c) = delete;
+    dsog_init_state& operator=(const dsog_init_state& c) = delete;
+
+    std::vector<const dsog_state*> inits_;
+  };
+
   /// \brief A state for spot::tgba_product.
   /// \ingroup tgba_on_the_fly_algorithms
   ///
@@ -189,6 +211,25 @@ namespace dsog
   };
 
 
+  /// \brief Iterate over the initial aggregates of a dsog_init_state.
+  class dsog_init_succ_iterator final: public spot::twa_succ_iterator
+  {
+  public:
+    dsog_init_succ_iterator(const dsog_init_state* s);
+
+    bool first() override;
+    bool next() override;
+    bool done() const override;
+    spot::state* dst() const override;
+    bdd cond() const override;
+    spot::acc_cond::mark_t acc() const override;
+
+  private:
+    const dsog_init_state* s_;
+    size_t pos_;
+  };
+
+
   /// \brief A lazy product.  (States are computed on the fly.)
   class dsog_tgba: public spot::twa
   {
@@ -44,7 +44,7 @@ namespace dsog
   dsog_tgta_succ_iterator::dsog_tgta_succ_iterator(const dsog_tgta* aut,
       const dsog_state* s, spot::twa_succ_iterator* left_iter,
       const sogIts & model) :
-    dsog_succ_iterator(aut, s, left_iter, model)
+    dsog_succ_iterator(aut, s, left_iter, model), tgta_(aut)
   {
   }
 
@@ -100,18 +100,8 @@ namespace dsog
             bdd ap_src = aut_->ap_reachable_from_left(left_);
             while (succstates_ == its::State::null)
               {
-                bdd changeset;
-                bdd dont_care_changeset = left_iter_->cond();
-                bdd succstates_cond = bddfalse;
-                while ((changeset = bdd_satoneset(dont_care_changeset, ap_src,
-                    bddtrue)) != bddfalse)
-                  {
-                    dont_care_changeset -= changeset;
-                    trace << "step(): compute succstates_ agrega"
-                        << "----> changeset = " << bdd_format_formula(
-                        aut_->get_dict(), changeset) << std::endl;
-                    succstates_cond |= bdd_setxor(cond(), changeset);
-                  }
+                bdd succstates_cond = tgta_->get_succ_condition(
+                    cur->get_cond(), left_iter_->cond(), ap_src);
 
                 its::Transition selector = model_.getSelector(succstates_cond);
                 succstates_ = selector(cur->get_succ());
@@ -178,21 +168,45 @@ namespace dsog
 		       const sogIts & right) :
     dsog_tgba(left, right)
   {
+    const state* lis = left_->get_init_state();
+    bdd ap = ap_reachable_from_left(lis);
+    trace << " dsog_tgta::dsog_tgta():" << left_->format_state(lis)
+        << "----> ap = " << bdd_format_formula(left_->get_dict(), ap)
+        << std::endl;
+    init_cond_ = bdd_setxor(ap, ap);
+    lis->destroy();
   }
 
   state*
   dsog_tgta::get_init_state() const
   {
-    const state* lis = left_->get_init_state();
-    bdd ap = ap_reachable_from_left(lis);
-    trace << " dsog_tgta::get_init_state():" << left_->format_state(lis)
-        << "----> ap = " << bdd_format_formula(left_->get_dict(), ap)
-        << std::endl;
     its::State m0 = model_.getInitialState();
-    dsog_state *init = new initial_dsog_state(lis, model_, m0, bdd_setxor(ap,
-        ap));
-    return init;
+    return new initial_dsog_state(left_->get_init_state(), model_, m0, init_cond_);
+  }
 
+  bdd
+  dsog_tgta::get_succ_condition(bdd src_cond, bdd dont_care, bdd ap_src) const
+  {
+    succ_cond_key key = { src_cond, dont_care, ap_src };
+    auto it = succ_cond_.find(key);
+    if (it != succ_cond_.end())
+      return it->second;
+
+    bdd cond = dont_care & src_cond;
+    bdd changeset;
+    bdd dont_care_changeset = dont_care;
+    bdd succstates_cond = bddfalse;
+    while ((changeset = bdd_satoneset(dont_care_changeset, ap_src,
+        bddtrue)) != bddfalse)
+      {
+        dont_care_changeset -= changeset;
+        trace << "get_succ_condition(): compute succstates_ agrega"
+            << "----> changeset = " << bdd_format_formula(
+            get_dict(), changeset) << std::endl;
+        succstates_cond |= bdd_setxor(cond, changeset);
+      }
+    succ_cond_.emplace(key, succstates_cond);
+    return succstates_cond;
   }
 
   spot::twa_succ_iterator*
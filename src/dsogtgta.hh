@@ -21,6 +21,7 @@
 #ifndef SPOT_TGTA_DSOGPRODUCT_HH
 # define SPOT_TGTA_DSOGPRODUCT_HH
 
+#include <map>
 #include "dsog.hh"
 
 namespace dsog
@@ -72,6 +73,8 @@ namespace dsog
     // to allow pretty printing of arc annotations
     friend class dsog_tgta;
 
+    // the product, holding the cached arc conditions
+    const dsog_tgta* tgta_;
   };
 
   /// \brief A lazy product.  (States are computed on the fly.)
@@ -88,6 +91,29 @@ namespace dsog
 
     virtual spot::twa_succ_iterator*
     succ_iter(const spot::state* local_stateb) const override;
+
+    /// The condition of the successor aggregate through an arc : the valuations reached from
+    /// the source valuation src_cond through one of the changesets of dont_care, over the APs ap_src.
+    /// Memoized, the same arcs are crossed from many aggregates.
+    bdd
+    get_succ_condition(bdd src_cond, bdd dont_care, bdd ap_src) const;
+
+  private:
+    // the condition of the artificial initial state, computed once
+    bdd init_cond_;
+
+    struct succ_cond_key {
+      // bdds are held to keep their ids valid
+      bdd src_cond, dont_care, ap_src;
+      bool operator< (const succ_cond_key & o) const {
+        if (src_cond.id() != o.src_cond.id())
+          return src_cond.id() < o.src_cond.id();
+        if (dont_care.id() != o.dont_care.id())
+          return dont_care.id() < o.dont_care.id();
+        return ap_src.id() < o.ap_src.id();
+      }
+    };
+    mutable std::map<succ_cond_key, bdd> succ_cond_;
   };
 
 }
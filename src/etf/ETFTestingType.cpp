@@ -1,5 +1,9 @@
 #include "ETFTestingType.hh"
 #include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <thread>
+#include <unordered_map>
 #include "ddd/Hom_Basic.hh"
 
 using std::vector;
@@ -25,25 +29,76 @@ namespace its
   //}
 
 
+  // number of edges read before their AP are evaluated
+  static const size_t BATCH_SIZE = 1024;
+
+  // maximum number of sections loaded concurrently, and thus held in memory at once
+  static const unsigned MAX_LOADERS = 8;
+
+  // hash of a pair of valuation masks
+  struct mask_hash {
+    size_t operator() (const vector<uint64_t> & mask) const {
+      size_t h = 0;
+      for (uint64_t w : mask)
+        h = h * 1000003 ^ (size_t) (w ^ (w >> 32));
+      return h;
+    }
+  };
+
+  // one tight loop per AP, with the comparison hoisted out of it
+#define EVAL_AP(cmp) \
+    for (size_t e = 0; e < count; ++e) \
+      word[e * W] |= (uint64_t) (col[e * N] cmp val) << shift;
+
+  void
+  EtfTestingType::evaluate_batch(const int* states, size_t count, int N, uint64_t* masks) const
+  {
+    size_t W = maskWords();
+    std::fill(masks, masks + count * W, 0);
+    for (size_t a = 0; a < observedAP.size(); ++a)
+      {
+        const AtomicProposition & prop = observedAP[a];
+        uint64_t * word = masks + a / 64;
+        int shift = a % 64;
+        const int * col = states + prop.var;
+        // values are offset by one in ETF state vectors
+        int val = prop.val + 1;
+        switch (prop.op)
+          {
+        case AtomicProposition::EQ:
+          EVAL_AP(==)
+          break;
+        case AtomicProposition::NE:
+          EVAL_AP(!=)
+          break;
+        case AtomicProposition::GT:
+          EVAL_AP(>)
+          break;
+        case AtomicProposition::LT:
+          EVAL_AP(<)
+          break;
+        case AtomicProposition::LE:
+          EVAL_AP(<=)
+          break;
+        case AtomicProposition::GE:
+          EVAL_AP(>=)
+          break;
+          }
+      }
+  }
+#undef EVAL_AP
+
   bdd
-  EtfTestingType::state_condition(int state[]) const
+  EtfTestingType::mask_condition(const uint64_t* mask) const
   {
     bdd res = bddtrue;
-    std::map<int, class AtomicProposition>::const_iterator it;
-    for (it = bddvar_to_AtomicProposition.begin(); it
-        != bddvar_to_AtomicProposition.end(); it++)
+    for (size_t a = 0; a < observedAP.size(); ++a)
       {
-        //std::cerr << " **********prop: " << it->first << std::endl;
-        //std::cerr << " **********statevar: " << (it->second).first << std::endl;
-        //std::cerr << " **********propvalue: " << (it->second).second
-        //<< std::endl;
-        AtomicProposition prop = (it->second);
-        if (prop.comp(state[prop.var] - 1, prop.val))
-          res &= bdd_ithvar(it->first);
+        if ((mask[a / 64] >> (a % 64)) & 1)
+          res &= bdd_ithvar(observedBddVar[a]);
         else
-          res &= bdd_nithvar(it->first);
+          res &= bdd_nithvar(observedBddVar[a]);
       }
-
     return res;
   }
 
@@ -96,31 +151,30 @@ namespace its
           }
       }
 
-    std::function<bool
-    (int, int)> comp = NULL;
+    AtomicProposition::comp_op_t comp;
     if (op == "=")
       {
-        comp = std::equal_to<int>();
+        comp = AtomicProposition::EQ;
       }
     else if (op == "!=")
       {
-        comp = std::not_equal_to<int>();
+        comp = AtomicProposition::NE;
       }
     else if (op == ">")
       {
-        comp = std::greater<int>();
+        comp = AtomicProposition::GT;
       }
     else if (op == "<")
       {
-        comp = std::less<int>();
+        comp = AtomicProposition::LT;
       }
     else if (op == "<=")
       {
-        comp = std::less_equal<int>();
+        comp = AtomicProposition::LE;
       }
     else if (op == ">=")
       {
-        comp = std::greater_equal<int>();
+        comp = AtomicProposition::GE;
       }
     else
       {
@@ -251,12 +305,103 @@ namespace its
   {
     //std::cerr << " setObservedAP " << std::endl;
     bddvar_to_AtomicProposition[bddvar] = parseAtomicProposition(atomicProp);
+    bddvar_to_label[bddvar] = atomicProp;
+
+    observedAP.clear();
+    observedBddVar.clear();
+    std::map<int, class AtomicProposition>::const_iterator it;
+    for (it = bddvar_to_AtomicProposition.begin(); it
+        != bddvar_to_AtomicProposition.end(); it++)
+      {
+        observedBddVar.push_back(it->first);
+        observedAP.push_back(it->second);
+      }
   }
 
+  // A group of edges of a section with the same pair of valuation masks : count edges, each stored as
+  // its projected src vector followed by its projected dst vector.
+  struct edge_group {
+    size_t count;
+    vector<int> values;
+    edge_group() : count(0) {}
+  };
+
+  struct EtfTestingType::section_edges {
+    // the variables touched by the section
+    vector<int> proj;
+    // edges, by pair of valuation masks (src then dst)
+    std::unordered_map<vector<uint64_t>, edge_group, mask_hash> groups;
+  };
+
   void
-  EtfTestingType::compute_transitions_by_changesets(std::set<bdd,
-      spot::bdd_less_than> allChangesets)
+  EtfTestingType::load_section(etf_rel_t trans, int N, int nbevents, section_edges & out) const
   {
+    // edges are read in batches, so that AP evaluation runs over contiguous state vectors
+    size_t W = maskWords();
+    vector<int> srcs(BATCH_SIZE * N);
+    vector<int> dsts(BATCH_SIZE * N);
+    vector<uint64_t> srcMasks(BATCH_SIZE * W);
+    vector<uint64_t> dstMasks(BATCH_SIZE * W);
+    vector<uint64_t> key(2 * W);
+    vector<int> lbl(nbevents);
+    int len = -1;
+
+    ETFrelIterate(trans);
+    bool more = true;
+    while (more)
+      {
+        size_t count = 0;
+        while (count < BATCH_SIZE
+            && (more = ETFrelNext(trans, &srcs[count * N], &dsts[count * N], lbl.data())))
+          {
+            ++count;
+          }
+        if (count == 0)
+          break;
+        if (len < 0)
+          {
+            // variables not touched by the section are 0 in its edges
+            for (int i = 0; i < N; i++)
+              {
+                if (srcs[i])
+                  {
+                    out.proj.push_back(i);
+                  }
+              }
+            len = out.proj.size();
+          }
+        evaluate_batch(&srcs[0], count, N, &srcMasks[0]);
+        evaluate_batch(&dsts[0], count, N, &dstMasks[0]);
+
+        for (size_t e = 0; e < count; ++e)
+          {
+            std::copy(&srcMasks[e * W], &srcMasks[(e + 1) * W], key.begin());
+            std::copy(&dstMasks[e * W], &dstMasks[(e + 1) * W], key.begin() + W);
+            edge_group & group = out.groups[key];
+            ++group.count;
+            const int * esrc = &srcs[e * N];
+            const int * edst = &dsts[e * N];
+            for (int ii = 0; ii < len; ++ii)
+              group.values.push_back(esrc[out.proj[ii]] - 1);
+            for (int ii = 0; ii < len; ++ii)
+              group.values.push_back(edst[out.proj[ii]] - 1);
+          }
+      }
+  }
+
+  void
+  EtfTestingType::compute_full_partition()
+  {
+    std::vector<std::pair<int, vLabel> > apKey(bddvar_to_label.begin(),
+        bddvar_to_label.end());
+    if (apKey == partitionAP && !fullChangesets.empty())
+      {
+        // same AP set as a previous formula
+        return;
+      }
+    partitionAP = apKey;
+    fullChangesets.clear();
+    fullPartition.clear();
 
     //std::cerr << " compute transitions by changeset: " << changeset
     //<< std::endl;
@@ -268,104 +413,149 @@ namespace its
     //std::cerr << "nbevents: " << nbevents << std::endl;
     //printf("N and nbevents %4d/%d\n",N,nbevents);
 
-    // Initialize the relation
-    //std::cerr << "Initialize the relation" << std::endl;
+    // Each section is streamed once into flat edge arrays. This touches neither BDD nor DDD,
+    // so independent sections are loaded by concurrent threads. Sections are handled by windows
+    // of one section per thread : a window is converted to DDD, and its buffers released, before
+    // the next one is loaded, so at most that many sections are held in memory.
+    vector<etf_rel_t> rels;
     for (int section = 0; section < nbevents; section++)
       {
+        rels.push_back(etf_trans_section(etfmodel, section));
+      }
+    unsigned window = std::min(MAX_LOADERS, std::max(1u, std::thread::hardware_concurrency()));
+    vector<section_edges> sections(window);
 
-        //printf("group %4d/%d\n", section + 1, nbevents);
-
-        etf_rel_t trans = etf_trans_section(etfmodel, section);
-
-        int src[N];
-        int dst[N];
-        int lbl[nbevents];
-
-        vector<int> proj;
+    // The full changeset of an edge only depends on the AP valuations of its src and dst :
+    // it is computed once per distinct pair of valuation masks.
+    size_t W = maskWords();
+    std::unordered_map<vector<uint64_t>, size_t, mask_hash> fullOfMasks;
+    std::unordered_map<int, size_t> fullOfId;
 
-        ETFrelIterate(trans);
-        if (ETFrelNext(trans, src, dst, lbl))
+    for (int first = 0; first < nbevents; first += window)
+      {
+        int last = std::min(nbevents, first + (int) window);
+        // ETFrelNext keeps its iteration state in the rel it is given : each thread only
+        // walks its own section, and no rel is shared between threads.
+        vector<std::thread> threads;
+        for (int section = first + 1; section < last; ++section)
           {
-            for (int i = 0; i < N; i++)
-              {
-                if (src[i])
-                  {
-                    proj.push_back(i);
-                  }
-              }
+            threads.emplace_back([&, section] () {
+                load_section(rels[section], N, nbevents, sections[section - first]);
+              });
+          }
+        load_section(rels[first], N, nbevents, sections[0]);
+        for (std::thread & t : threads)
+          {
+            t.join();
           }
-        int len = proj.size();
-
-	std::unordered_map<int, ETFTransition> bdd_to_ETFtransition;
 
-        ETFrelIterate(trans);
-        while (ETFrelNext(trans, src, dst, lbl))
+        // Initialize the relation, in section order
+        //std::cerr << "Initialize the relation" << std::endl;
+        for (int section = first; section < last; section++)
           {
-            bdd changeset = bdd_setxor(state_condition(src), state_condition(
-                dst));
-            //std::cerr << " ******** changeset between src and dst: " << changeset << std::endl;
-            std::set<bdd, spot::bdd_less_than>::iterator it;
-            for (it = allChangesets.begin(); it != allChangesets.end(); ++it)
-              {
-                bdd dont_care_changeset = *it;
+            section_edges & edges = sections[section - first];
+            const vector<int> & proj = edges.proj;
+            size_t len = proj.size();
 
-                if (bdd_implies(changeset, dont_care_changeset))
-                  {
-		    std::unordered_map<int, ETFTransition>::iterator
-                        iteratorETFtransition = bdd_to_ETFtransition.find(
-                            dont_care_changeset.id());
+            // indexed like fullChangesets
+            std::map<size_t, ETFTransition> index_to_ETFtransition;
 
-                    if (iteratorETFtransition == bdd_to_ETFtransition.end())
+            for (auto & group : edges.groups)
+              {
+                const vector<uint64_t> & key = group.first;
+                auto full = fullOfMasks.find(key);
+                if (full == fullOfMasks.end())
+                  {
+                    bdd changeset = bdd_setxor(mask_condition(&key[0]),
+                        mask_condition(&key[W]));
+                    //std::cerr << " ******** changeset between src and dst: " << changeset << std::endl;
+                    auto id = fullOfId.find(changeset.id());
+                    if (id == fullOfId.end())
                       {
-                        iteratorETFtransition
-                            = (bdd_to_ETFtransition.insert(std::pair<int,
-                                ETFTransition>(dont_care_changeset.id(),
-                                ETFTransition(proj)))).first;
+                        id = fullOfId.insert(std::make_pair(changeset.id(), fullChangesets.size())).first;
+                        fullChangesets.push_back(changeset);
                       }
+                    full = fullOfMasks.insert(std::make_pair(key, id->second)).first;
+                  }
 
-                    int psrc[len];
-                    int pdst[len];
-
-                    for (int ii = 0; ii < len; ++ii)
-                      {
-                        psrc[ii] = src[proj[ii]] - 1;
-                        pdst[ii] = dst[proj[ii]] - 1;
-                      }
+                std::map<size_t, ETFTransition>::iterator
+                    iteratorETFtransition = index_to_ETFtransition.find(full->second);
 
-                    (iteratorETFtransition->second).addEdge(psrc, pdst);
+                if (iteratorETFtransition == index_to_ETFtransition.end())
+                  {
+                    iteratorETFtransition
+                        = (index_to_ETFtransition.insert(std::pair<size_t,
+                            ETFTransition>(full->second, ETFTransition(proj)))).first;
                   }
 
+                // ETFTransition only accepts edges one at a time : the group is still added edge by
+                // edge, but from one contiguous array and with its changeset looked up once.
+                int * values = group.second.values.data();
+                for (size_t e = 0; e < group.second.count; ++e, values += 2 * len)
+                  {
+                    (iteratorETFtransition->second).addEdge(values, values + len);
+                  }
               }
 
+            fullPartition.insert(fullPartition.end(), index_to_ETFtransition.begin(),
+                index_to_ETFtransition.end());
+
+            // release the edge buffers of the section
+            edges = section_edges();
           }
+      }
+    //std::cerr << fullChangesets.size() << " full changesets" << std::endl;
+  }
 
-        auto i = bdd_to_ETFtransition.begin();
-        while (i != bdd_to_ETFtransition.end())
+  void
+  EtfTestingType::compute_transitions_by_changesets(std::set<bdd,
+      spot::bdd_less_than> allChangesets)
+  {
+    compute_full_partition();
+
+    // results of a previous formula are keyed by bdd ids that may no longer mean the same
+    changeset_to_transitions.clear();
+    changeset_to_locals.clear();
+    changesets_to_locals.clear();
+
+    // a don't care changeset is the union of the full changesets that imply it
+    vector<bool> matched(fullChangesets.size());
+    for (const bdd & changeset : allChangesets)
+      {
+        for (size_t k = 0; k < fullChangesets.size(); ++k)
           {
-            changeset_to_transitions[i->first].push_back(i->second);
-            ++i;
+            matched[k] = bdd_implies(fullChangesets[k], changeset);
           }
-
+        vector<ETFTransition> transitions;
+        for (const auto & part : fullPartition)
+          {
+            if (matched[part.first])
+              transitions.push_back(part.second);
+          }
+        if (!transitions.empty())
+          changeset_to_transitions[changeset.id()] = transitions;
       }
-
   }
 
+
   /** state and transitions representation functions, selected by changeset */
   /** Local transitions by changeset*/
   Transition
   EtfTestingType::getLocalsByChangeSet(bdd changeset) const
   {
-
-    vector<ETFTransition> transitions;
-    auto i = changeset_to_transitions.find(changeset.id());
-    if (i != changeset_to_transitions.end())
+    auto memo = changeset_to_locals.find(changeset.id());
+    if (memo != changeset_to_locals.end())
       {
-        transitions = i->second;
+        return memo->second;
       }
-    else
+
+    auto i = changeset_to_transitions.find(changeset.id());
+    if (i == changeset_to_transitions.end())
       {
+        changeset_to_locals[changeset.id()] = Transition::null;
         return Transition::null;
       }
+    const vector<ETFTransition> & transitions = i->second;
 
     //compute_transitions_by_changeset(transitions, changeset);
 
@@ -376,7 +566,35 @@ namespace its
         toadd.insert(it->getShom());
       }
 
-    return GShom::add(toadd);
+    Transition res = GShom::add(toadd);
+    changeset_to_locals[changeset.id()] = res;
+    return res;
+  }
+
+  Transition
+  EtfTestingType::getLocalsByChangeSets(const std::vector<bdd> & changesets) const
+  {
+    vector<int> ids;
+    for (const bdd & changeset : changesets)
+      {
+        ids.push_back(changeset.id());
+      }
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+
+    auto memo = changesets_to_locals.find(ids);
+    if (memo != changesets_to_locals.end())
+      {
+        return memo->second;
+      }
+
+    Transition res = Transition::null;
+    for (const bdd & changeset : changesets)
+      {
+        res = res + getLocalsByChangeSet(changeset);
+      }
+    changesets_to_locals[ids] = res;
+    return res;
   }
 
 //EtfTestingType::~EtfTestingType() {
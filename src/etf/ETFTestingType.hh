@@ -16,16 +16,22 @@
 #include <spot/misc/hash.hh>
 #include "its/etf/ETFType.hh"
 #include <spot/misc/bddlt.hh>
+#include <vector>
+#include <cstdint>
+#include <map>
+#include <unordered_map>
 
 namespace its {
 // hold the result of a parse
  class AtomicProposition {
  public :
+   // the comparison operators of a predicate
+   enum comp_op_t { EQ, NE, GT, LT, LE, GE };
    int var;
-   std::function<bool(int,int)> comp;
+   comp_op_t op;
    int val;
-   AtomicProposition(int var, std::function<bool(int,int)> comp, int val) : var(var),comp(comp),val(val) {}
-   AtomicProposition() : var(-1),comp(NULL),val(-1) {}
+   AtomicProposition(int var, comp_op_t op, int val) : var(var),op(op),val(val) {}
+   AtomicProposition() : var(-1),op(EQ),val(-1) {}
  };
 
 
@@ -40,12 +46,35 @@ class EtfTestingType: public EtfType {
 	// corresponding indexes of variables in the states (etfmodel) and their value
 	// in the atomic proposition.
 	std::map<int, class AtomicProposition> bddvar_to_AtomicProposition;
+	// the text of the same AP
+	std::map<int, vLabel> bddvar_to_label;
+
+	// The same AP as a flat table, ordered by bdd variable : bit i of a valuation mask is the
+	// truth value of observedAP[i], whose bdd variable is observedBddVar[i].
+	std::vector<AtomicProposition> observedAP;
+	std::vector<int> observedBddVar;
+	// number of 64 bit words in a valuation mask
+	size_t maskWords() const { return observedAP.empty() ? 1 : (observedAP.size() + 63) / 64; }
 
         std::unordered_map<int, std::vector<class ETFTransition>>
 			   changeset_to_transitions;
 
 	vLabel name;
 
+	// The model relation partitioned by full changeset (the exact set of AP that change along an edge).
+	// It only depends on the observed AP, so it is kept across formulas with the same AP set.
+	std::vector<std::pair<int, vLabel> > partitionAP;
+	std::vector<bdd> fullChangesets;
+	// (index in fullChangesets, edges of one section with that changeset)
+	std::vector<std::pair<size_t, class ETFTransition> > fullPartition;
+	// compute the partition, unless it is up to date
+	void compute_full_partition();
+
+	// memoized results of getLocalsByChangeSet, by changeset id
+	mutable std::unordered_map<int, Transition> changeset_to_locals;
+	// memoized results of getLocalsByChangeSets, by sorted changeset ids
+	mutable std::map<std::vector<int>, Transition> changesets_to_locals;
+
 	// a helper function that parses the input ETF file using the primitives of LTSmin and produces the corresponding data structures.
 	//void
 	//compute_transitions(std::vector<class ETFTransition> & transitions) const;
@@ -58,7 +87,17 @@ protected:
 
 	// Set an observed atomic proposition : the string corresponding to the AP identifier is then related to the bdd var of index
 	AtomicProposition parseAtomicProposition(Label atomicProp) const;
-	bdd state_condition(int* state) const;
+	// Compute the valuation masks of count state vectors of length N, stored contiguously in states.
+	// masks must hold count * maskWords() words.
+	void evaluate_batch(const int* states, size_t count, int N, uint64_t* masks) const;
+	// The conjunction of AP literals described by a valuation mask.
+	bdd mask_condition(const uint64_t* mask) const;
+
+	// The edges of a section, grouped by pair of valuation masks (defined in the .cpp).
+	struct section_edges;
+	// Stream the edges of an ETF section once into out. Touches neither BDD nor DDD,
+	// so that several sections may be loaded concurrently.
+	void load_section(etf_rel_t trans, int N, int nbevents, section_edges & out) const;
 
 	//	vector<class ETFTransition>  get_transitions_by_changeset() {
 	//		changeset_to_transitions
@@ -80,6 +119,9 @@ public:
 	/** Local transitions by changeset*/
 	Transition getLocalsByChangeSet(bdd changeset) const;
 
+	/** The union of getLocalsByChangeSet over a set of changesets (order and repetitions do not matter).*/
+	Transition getLocalsByChangeSets(const std::vector<bdd> & changesets) const;
+
 /** The state predicate function : string p -> SHom.
 	 *  returns a selector homomorphism that selects states verifying the predicate 'p'.
 	 *  The syntax of the predicate is left to the concrete type realization.
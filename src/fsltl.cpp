@@ -1,5 +1,10 @@
 #include "fsltl.hh"
 #include "tgbaIts.hh"
+#include "ddd/DDD.h"
+#include "ddd/SDD.h"
+
+#include <vector>
+#include <algorithm>
 
 
 // #define trace std::cerr
@@ -10,9 +15,28 @@ namespace its {
 
   // Create a type to hold a spot TGBA
   bool fsltlModel::declareType (spot::const_twa_ptr tgba) {
-    TgbaType * newtgba = new TgbaType (tgba);
+    TgbaType * newtgba = new TgbaType (tgba, tgbaEncoding_);
     // store reference for later use
     tgba_ = newtgba;
+    // the model is reused for each formula : forget the product of the previous automaton
+    allTrans_ = Transition::null;
+    accToTrans_.clear();
+    isGenBuchi_ = true;
+    clauses_.clear();
+    lastClause_ = 0;
+    sccBuilt_ = false;
+    sccTrans_.clear();
+    sccAccToTrans_.clear();
+    stutterSteps_.clear();
+    reach_ = State::null;
+    reachLayers_.clear();
+    fairFired_.clear();
+    fairBuilt_ = false;
+    weakAccs_.clear();
+    weakNames_.clear();
+    strongFair_.clear();
+    strongNames_.clear();
+    stats_ = hull_stats_t();
     // Compute and store the AP set to update the sogIts component
     // ??? how to is in the sogtgbautils file.
     return addType(newtgba);
@@ -49,32 +73,129 @@ namespace its {
     // Grab the TGBA labels
     labels_t tgbalabs = tgba_->getTransLabels();
 
+    // with cone of influence reduction, the sliced relation replaces the full one
+    Transition modelRel = sogIts_->isConeOfInfluence() ? sogIts_->getModelRel() : getInstance()->getType()->getLocals();
+
+    // the model transitions under fairness
+    std::map<std::string, Transition> fairRels;
+    if (sogIts_->hasFairness()) {
+      labels_t fair = sogIts_->getWeakFairness();
+      fair.insert(fair.end(), sogIts_->getStrongFairness().begin(), sogIts_->getStrongFairness().end());
+      for (labels_it it = fair.begin() ; it != fair.end() ; ++it) {
+	Transition t = sogIts_->getNamedTransition(*it);
+	if (t == Transition::null) {
+	  std::cerr << "No transition named " << *it << " in the model, for fairness constraint.\n" ;
+	  return false;
+	}
+	fairRels [*it] = t;
+	fairFired_ [*it] = Transition::null;
+      }
+    }
+    if (! fairFired_.empty() && ! tgba_->getAcceptance().is_generalized_buchi()) {
+      // checking without them could report an unfair run
+      std::cerr << "Fairness constraints are only supported with generalized Buchi automata.\n" ;
+      return false;
+    }
+
+    // with stutter saturation, the model side of each label, before it is lifted in the product
+    std::map<vLabel, Transition> modelSteps;
+
+    // One label per AP condition : the model side is built once per condition,
+    // acceptance relations only restrict the automaton side.
     for (labels_it it = tgbalabs.begin() ; it != tgbalabs.end() ; ++it ) {
       trace << "label :" << *it << std::endl;
-      TgbaType::tgba_arc_label_t arcLab = tgba_->getTransLabelDescription(*it);
-      trace << "desc :" << arcLab.first << ":" << arcLab.second << std::endl;
-      Transition apcond = sogIts_->getSelector(arcLab.first, getInstance()->getType());
+      bdd cond = tgba_->getTransLabelCondition(*it);
+      Transition apcond = sogIts_->getSelector(cond, getInstance()->getType());
+      Transition modelPart = localApply(modelRel  & apcond, modelVar());
 
       labels_t labtodo;
       labtodo.push_back(*it);
-      Transition toadd = localApply(tgba_->getSuccs(labtodo),1) & localApply(getInstance()->getType()->getLocals()  & apcond, 0) ;
+      if (stutterSaturation_) {
+	// self loops are added below, saturated
+	modelSteps [*it] = modelRel & apcond;
+	Transition moves = tgba_->getSuccsWithoutSelfLoops(*it);
+	if (moves != Transition::null)
+	  allTrans_ = allTrans_ + (localApply(moves, tgbaVar()) & modelPart);
+      } else {
+	Transition toadd = localApply(tgba_->getSuccs(labtodo), tgbaVar()) & modelPart ;
+	allTrans_ = allTrans_ + toadd;
+      }
 
-      allTrans_ = allTrans_ + toadd;
+      // the steps of this label that fire a fair transition
+      for (std::map<std::string, Transition>::iterator fit = fairFired_.begin() ; fit != fairFired_.end() ; ++fit) {
+	fit->second = fit->second + (localApply(tgba_->getSuccs(labtodo), tgbaVar()) & localApply(fairRels[fit->first] & apcond, modelVar()));
+      }
 
-      labels_t accs = tgba_->getAcceptanceSet(arcLab.second);
+      labels_t accs = tgba_->getTransLabelAcceptance(*it);
       for (labels_it acc = accs.begin() ; acc != accs.end() ; ++acc) {
+	Transition accadd = localApply(tgba_->getSuccsByAcc(*it, *acc), tgbaVar()) & modelPart ;
 	accToTrans_it accit = accToTrans_.find(*acc);
 	if (accit == accToTrans_.end()) {
 	  // first occurrence
-	  accToTrans_ [*acc] = toadd;
+	  accToTrans_ [*acc] = accadd;
 	} else {
-	  accit->second = accit->second + toadd;
+	  accit->second = accit->second + accadd;
+	}
+      }
+
+      if (sccDecomposition_) {
+	// the same arcs, restricted to each accepting automaton SCC
+	for (int scc = 0 ; scc < tgba_->getSCCCount() ; ++scc) {
+	  if (! tgba_->isAcceptingSCC(scc))
+	    continue;
+	  Transition inner = tgba_->getSuccsInSCC(labtodo, scc);
+	  if (inner == Transition::null)
+	    continue;
+	  Transition sccadd = localApply(inner, tgbaVar()) & modelPart ;
+	  std::map<int, Transition>::iterator sit = sccTrans_.find(scc);
+	  if (sit == sccTrans_.end()) {
+	    sccTrans_ [scc] = sccadd;
+	  } else {
+	    sit->second = sit->second + sccadd;
+	  }
+	  accToTrans_t & sccAccs = sccAccToTrans_[scc];
+	  for (labels_it acc = accs.begin() ; acc != accs.end() ; ++acc) {
+	    Transition accinner = tgba_->getSuccsByAcc(*it, *acc, scc);
+	    if (accinner == Transition::null)
+	      continue;
+	    Transition accadd = localApply(accinner, tgbaVar()) & modelPart ;
+	    accToTrans_it accit = sccAccs.find(*acc);
+	    if (accit == sccAccs.end()) {
+	      sccAccs [*acc] = accadd;
+	    } else {
+	      accit->second = accit->second + accadd;
+	    }
+	  }
 	}
       }
 
     }
 
 
+      if (stutterSaturation_) {
+	// While the automaton stays in state q, the model may fire any step allowed by a self loop of q.
+	// Such a stretch is a single step T+ = T & T* of the product, where T* is a saturated fixpoint on the model alone.
+	// T+ has the same reachable states and the same cycles as T, and acceptance relations keep single steps.
+	std::map<int, labels_t> loops = tgba_->getSelfLoops();
+	for (std::map<int, labels_t>::const_iterator it = loops.begin() ; it != loops.end() ; ++it) {
+	  Transition stutter = Transition::null;
+	  for (labels_it lab = it->second.begin() ; lab != it->second.end() ; ++lab)
+	    stutter = stutter + modelSteps[*lab];
+	  Transition closure = stutter & fixpoint(stutter + Transition::id, true);
+	  Transition selector = localApply(tgba_->getStateSelector(it->first), tgbaVar());
+	  allTrans_ = allTrans_ + (selector & localApply(closure, modelVar()));
+	  stutterSteps_.push_back(std::make_pair(selector, stutter));
+	}
+	trace << "Saturated self loops on " << loops.size() << " automaton states" << std::endl;
+      }
+
+      if (! tgba_->getAcceptance().is_generalized_buchi()) {
+	buildAcceptanceClauses(modelRel);
+      } else if (sccDecomposition_) {
+	sccBuilt_ = true;
+	trace << "Product restricted to " << sccTrans_.size() << " accepting automaton SCC out of " << tgba_->getSCCCount() << std::endl;
+      }
+
 //       std::cout << "Built model with initstate :" << getInitState() << std::endl;
 //       std::cout << "Transition rel (all) :" << allTrans_ << std::endl;
 
@@ -82,9 +203,59 @@ namespace its {
       return true;
     }
 
+  // Each clause of the DNF of the acceptance condition is Fin(F) & Inf(I) : a run is accepted by the clause if its cycle
+  // avoids all arcs marked by F, and visits arcs marked by each set of I.
+  // So the clause is checked as a generalized Buchi condition I, on the product restricted to arcs without marks in F.
+  void fsltlModel::buildAcceptanceClauses (Transition modelRel) {
+    isGenBuchi_ = false;
+    labels_t tgbalabs = tgba_->getTransLabels();
+    spot::acc_cond::acc_code dnf = tgba_->getAcceptance().get_acceptance().to_dnf();
+    if (dnf.is_f()) {
+      // no run is accepted : no clause, every check is empty
+      trace << "Acceptance is false" << std::endl;
+      return;
+    }
+    if (dnf.is_t()) {
+      // every cycle is accepted, whatever its marks
+      acc_clause_t clause;
+      clause.all = allTrans_;
+      clauses_.push_back(clause);
+      trace << "Acceptance is true" << std::endl;
+      return;
+    }
+    for (const spot::acc_cond::acc_code & code : dnf.top_disjuncts()) {
+      std::pair<spot::acc_cond::mark_t, spot::acc_cond::mark_t> infFin = code.used_inf_fin_sets();
+      labels_t infs = TgbaType::getAcceptanceSet(infFin.first);
+
+      acc_clause_t clause;
+      clause.all = Transition::null;
+      clause.accs.assign(infs.size(), Transition::null);
+      for (labels_it it = tgbalabs.begin() ; it != tgbalabs.end() ; ++it ) {
+	Transition kept = tgba_->getSuccsAvoiding(*it, infFin.second);
+	if (kept == Transition::null)
+	  continue;
+	Transition apcond = sogIts_->getSelector(tgba_->getTransLabelCondition(*it), getInstance()->getType());
+	Transition modelPart = localApply(modelRel  & apcond, modelVar());
+	clause.all = clause.all + (localApply(kept, tgbaVar()) & modelPart);
+	for (size_t i = 0 ; i < infs.size() ; ++i) {
+	  Transition acc = tgba_->getSuccsAvoiding(*it, infFin.second, infs[i]);
+	  if (acc != Transition::null)
+	    clause.accs[i] = clause.accs[i] + (localApply(acc, tgbaVar()) & modelPart);
+	}
+      }
+      clause.names = infs;
+      trace << "Acceptance clause " << code << std::endl;
+      clauses_.push_back(clause);
+    }
+  }
+
   State fsltlModel::getInitState () {
 //    return State(1, getInstance()->getType()->getState("init"), State(0, findType("TGBA")->getState("init")));
-    return State(1, findType("TGBA")->getState("init"), State(0, getInstance()->getType()->getState("init")));
+    if (tgbaOnTop_) {
+      return State(1, tgba_->getState("init"), State(0, getInstance()->getType()->getState("init")));
+    } else {
+      return State(1, getInstance()->getType()->getState("init"), State(0, tgba_->getState("init")));
+    }
   }
 
   Transition fsltlModel::getNextByAll () {
@@ -96,9 +267,101 @@ namespace its {
   }
 
 
-  State fsltlModel::findSCC_fsltl (its::Transition nextAll, const trans_t & nextAccs, its::State init, bool isOWCTY) {
+  // Number of image steps allowed to a decision probe, in each direction.
+  static const int PROBE_BOUND = 64;
+
+  // Decision only mode : pick a seed in the current approximation, and look for its SCC inside the set
+  // with at most PROBE_BOUND image steps in each direction.
+  // Returns the SCC of the seed if it is fair, null if it is not or if the bound was reached.
+  static State probeFairSCC (Transition nextAll, Transition preAll, const fsltlModel::trans_t & nextAccs, const State & set) {
+    State seed = fsltlModel::pickOne(set);
+    if (seed.nbStates() != 1) {
+      // intersection of forward and backward sets of several states is not an SCC
+      return State::null;
+    }
+    State fwd = seed;
+    State front = seed;
+    for (int i = 0 ; front != State::null ; ++i) {
+      if (i == PROBE_BOUND)
+	return State::null;
+      front = (nextAll (front) * set) - fwd;
+      fwd = fwd + front;
+    }
+    State bwd = seed;
+    front = seed;
+    for (int i = 0 ; front != State::null ; ++i) {
+      if (i == PROBE_BOUND)
+	return State::null;
+      front = (preAll (front) * fwd) - bwd;
+      bwd = bwd + front;
+    }
+    State scc = fwd * bwd;
+    if (! fsltlModel::isFairSCC (nextAll, nextAccs, scc))
+      return State::null;
+    trace << "Decision probe found a fair SCC of " << scc.nbStates() << " states." << std::endl;
+    return scc;
+  }
+
+  // Each iteration applies trim, then each closure in turn, intersected with the current set so that
+  // the approximation only shrinks whatever the order of the closures.
+  // If adaptive, the closures are reordered after each iteration : the one that removed the most states goes first.
+  State fsltlModel::hullLoop (Transition trim, const trans_t & closures, State div, bool decisionOnly,
+			      Transition nextAll, Transition preAll, const trans_t & nextAccs, bool adaptive, scc_stats_t * stats) {
+    std::vector<size_t> order (closures.size());
+    for (size_t i = 0 ; i < order.size() ; ++i)
+      order[i] = i;
+    // counting the states is a traversal of the hull : only done when it is used
+    bool count = adaptive || stats;
+    std::vector<double> removed (closures.size(), 0);
+    if (stats && stats->removed.size() < closures.size())
+      stats->removed.resize(closures.size(), 0);
+
+    State sat;
+    do {
+      trace << "start of SCC loop with nbstates= " << div.nbStates()<<std::endl;
+      if (stats)
+	++stats->iterations;
+      sat = div;
+
+      div = trim (div);
+      double size = count ? div.nbStates() : 0;
+
+      // For each acceptance condition
+      for (std::vector<size_t>::const_iterator it = order.begin() ; it != order.end() ; ++it) {
+	div = div * closures[*it] (div);
+	if (count) {
+	  double after = div.nbStates();
+	  removed[*it] = size - after;
+	  size = after;
+	}
+	if (stats) {
+	  ++stats->closures;
+	  stats->removed[*it] += removed[*it];
+	}
+
+	trace << "Reduced to " << div.nbStates() << " states." << std::endl;
+	if (div == State::null)
+	  return div;
+      }
+      if (adaptive)
+	std::stable_sort(order.begin(), order.end(),
+			 [&removed] (size_t a, size_t b) { return removed[a] > removed[b]; });
+
+      if (decisionOnly && div != sat) {
+	State scc = probeFairSCC (nextAll, preAll, nextAccs, div);
+	if (scc != State::null)
+	  return scc;
+      }
+    } while (div != sat);
+    return div;
+  }
+
+  State fsltlModel::findSCC_fsltl (its::Transition nextAll, const trans_t & nextAccs, its::State init, bool isOWCTY, bool decisionOnly,
+				   scc_stats_t * stats, bool adaptive) {
 
     State reach = fixpoint (nextAll  + Transition::id, true) ( init );
+    // only used by decision probes
+    Transition preAll = decisionOnly ? nextAll.invert(reach) : Transition::null;
 
 //     trace << "Reachable states : " << reach.nbStates();
 //     if (reach.nbStates() < 15)
@@ -109,70 +372,364 @@ namespace its {
       // No acceptance condition : any cycle is accepting
       div = fixpoint (nextAll, true) (reach);
     } else {
-      // Fixpoint on all acceptance conds
-      div = reach;
-      State sat = div;
-      int j=0;
-      do {
-	trace << "start of SCC loop, iteration " << j++ << " with nbstates= " << div.nbStates()<<std::endl;
-	sat = div;
+      // The closures are built once, and reused by all iterations.
+      // OWCTY variant : only keep states that have a predecessor in the set
+      Transition trim = isOWCTY ? fixpoint (nextAll * Transition::id, true) : Transition::id;
+
+      // Let Next = all transitions (any label or acceptance)
+      // and black = successors that validate the acceptance condition "black"
+      // ( (Next + Id)^* & black ) (states)
+      Transition star = fixpoint (nextAll + Transition::id, true);
+      trans_t closures;
+      for (trans_it accit = nextAccs.begin(); accit != nextAccs.end() ; ++accit) {
+	closures.push_back(star & (*accit));
+      }
+
+      div = hullLoop (trim, closures, reach, decisionOnly, nextAll, preAll, nextAccs, adaptive, stats);
+    }
+    trace << "Divergence ? " << div.nbStates() << std::endl;
+    if (div.nbStates() < 15)
+      trace << div << std::endl;
 
+    return div;
 
-	if (isOWCTY) {
-	  // OWCTY variant
-	  // only states that allow a loop and suffixes
-	  div = fixpoint (nextAll, true) (div);
-	}
+  }
 
-	// trace << "After loop detection " << j << " with nbstates= " << div.nbStates()<<std::endl;
 
-	// For each acceptance condition
-	for (trans_it accit = nextAccs.begin(); accit != nextAccs.end() ; ++accit) {
 
 
-	  // Let Next = all transitions (any label or acceptance)
-	  // and black = successors that validate the acceptance condition "black"
-	  // ( (Next + Id)^* & black ) (states)
-	  // NB: creating t before application is necessary to enforce proper ref count
-	  // otherwise the composition could be gc'ed by the fixpoint's true attribute.
-	  its::Transition  t =  (fixpoint (nextAll + Transition::id,true) & (*accit));
+  // Backward hull : same structure as findSCC_fsltl, but the reachable states are only used to invert the relations.
+  State fsltlModel::findSCC_fsltl_bwd (its::Transition nextAll, const trans_t & nextAccs, its::State init, bool isOWCTY, bool decisionOnly,
+				       scc_stats_t * stats, bool adaptive) {
 
-	  div = t (div);
+    State reach = fixpoint (nextAll  + Transition::id, true) ( init );
 
-	  trace << "Reduced to " << div.nbStates() << " states." << std::endl;
-	}
+    // predecessor relations, restricted to reachable states
+    Transition preAll = nextAll.invert(reach);
 
-      } while (div != sat);
+    State div;
+    if (nextAccs.empty()) {
+      // No acceptance condition : any cycle is accepting
+      // keep states that have a successor in the set
+      div = fixpoint (preAll * Transition::id, true) (reach);
+    } else {
+      // OWCTY variant : only keep states that have a successor in the set
+      Transition trim = isOWCTY ? fixpoint (preAll * Transition::id, true) : Transition::id;
+
+      // states that can reach (Pre + Id)^*, a predecessor by acceptance condition "black" of the set.
+      Transition star = fixpoint (preAll + Transition::id, true);
+      trans_t closures;
+      for (trans_it accit = nextAccs.begin(); accit != nextAccs.end() ; ++accit) {
+	closures.push_back(star & accit->invert(reach));
+      }
+
+      div = hullLoop (trim, closures, reach, decisionOnly, nextAll, preAll, nextAccs, adaptive, stats);
     }
     trace << "Divergence ? " << div.nbStates() << std::endl;
-    if (div.nbStates() < 15)
-      trace << div << std::endl;
 
     return div;
+  }
+
+  // fair : non trivial, and each acceptance condition has an arc inside the SCC
+  bool fsltlModel::isFairSCC (its::Transition nextAll, const trans_t & nextAccs, const State & scc) {
+    if ((nextAll (scc) * scc) == State::null)
+      return false;
+    for (trans_it accit = nextAccs.begin(); accit != nextAccs.end() ; ++accit) {
+      if (((*accit) (scc) * scc) == State::null)
+	return false;
+    }
+    return true;
+  }
+
+  // Walk down the first arc of each node.
+  State fsltlModel::pickOne (const State & s) {
+    if (s == State::null || s == State::one || s == State::top) {
+      return s;
+    }
+    GSDD::const_iterator it = s.begin();
+    const DataSet * val = it->first;
+    if (const SDD * sval = dynamic_cast<const SDD *>(val)) {
+      return GSDD(s.variable(), SDD(pickOne(*sval)), pickOne(it->second));
+    } else if (const DDD * dval = dynamic_cast<const DDD *>(val)) {
+      GDDD d = *dval;
+      std::vector<std::pair<int,int> > path;
+      while (d != GDDD::one && d != GDDD::null && d != GDDD::top) {
+	GDDD::const_iterator dit = d.begin();
+	path.push_back(std::make_pair(d.variable(), dit->first));
+	d = dit->second;
+      }
+      GDDD one = d;
+      for (auto pit = path.rbegin() ; pit != path.rend() ; ++pit) {
+	one = GDDD(pit->first, pit->second, one);
+      }
+      return GSDD(s.variable(), DDD(one), pickOne(it->second));
+    } else {
+      return GSDD(s.variable(), *val, pickOne(it->second));
+    }
+  }
+
+  // Lockstep : pick a seed, grow its forward and backward sets alternately,
+  // the first to converge bounds the SCC of the seed, which is their intersection.
+  // The two halves of the partition left are then explored independently.
+  State fsltlModel::getEnabled (its::Transition t, its::State reach) {
+    return t.invert(reach) (t (reach)) * reach;
+  }
 
+  Transition fsltlModel::getWeakFairRel (its::Transition nextAll, its::Transition fired, its::State enabled, its::State reach) {
+    return fired + (nextAll & ((reach - enabled) * Transition::id));
   }
 
+  State fsltlModel::findSCC_lockstep (its::Transition nextAll, const trans_t & nextAccs, its::State init, const strong_fairs_t & strong) {
 
+    State reach = fixpoint (nextAll  + Transition::id, true) ( init );
 
+    Transition preAll = nextAll.invert(reach);
+    // remove states without a predecessor or without a successor in the set
+    Transition trim = fixpoint ( (nextAll * Transition::id) & (preAll * Transition::id), true);
+
+    std::vector<State> todo;
+    todo.push_back(reach);
+    int nbscc = 0;
+    while (! todo.empty()) {
+      State V = trim (todo.back());
+      todo.pop_back();
+      if (V == State::null) {
+	continue;
+      }
 
-  State fsltlModel::findSCC_owcty () {
-    trans_t nextAccs;
-    for (accToTrans_it accit = accToTrans_.begin() ; accit != accToTrans_.end() ; ++accit ) {
-      nextAccs.push_back(accit->second);
-      trace << "For acceptance condition  :" <<  accit->first << std::endl ;
+      State seed = pickOne(V);
+      if (seed.nbStates() != 1) {
+	// cannot split the state space further, use a hull algorithm on this subset
+	trace << "Lockstep cannot pick a single state, using backward Emerson-Lei on " << V.nbStates() << " states." << std::endl;
+	Transition inV = V * Transition::id;
+	trans_t accsV;
+	for (trans_it accit = nextAccs.begin(); accit != nextAccs.end() ; ++accit) {
+	  accsV.push_back(inV & (*accit));
+	}
+	State res = findSCC_el_bwd (inV & nextAll, accsV, V);
+	if (res != State::null) {
+	  return res;
+	}
+	continue;
+      }
+
+      State fwd = seed;
+      State bwd = seed;
+      State ffront = seed;
+      State bfront = seed;
+      while (ffront != State::null && bfront != State::null) {
+	ffront = (nextAll (ffront) * V) - fwd;
+	fwd = fwd + ffront;
+	bfront = (preAll (bfront) * V) - bwd;
+	bwd = bwd + bfront;
+      }
+
+      State converged;
+      if (ffront == State::null) {
+	converged = fwd;
+	// finish the backward search inside the forward set
+	bwd = bwd * fwd;
+	bfront = bfront * fwd;
+	while (bfront != State::null) {
+	  bfront = (preAll (bfront) * fwd) - bwd;
+	  bwd = bwd + bfront;
+	}
+      } else {
+	converged = bwd;
+	fwd = fwd * bwd;
+	ffront = ffront * bwd;
+	while (ffront != State::null) {
+	  ffront = (nextAll (ffront) * bwd) - fwd;
+	  fwd = fwd + ffront;
+	}
+      }
+
+      State scc = fwd * bwd;
+      ++nbscc;
+      trace << "Lockstep SCC " << nbscc << " with nbstates= " << scc.nbStates() << std::endl;
+
+      if (isFairSCC (nextAll, nextAccs, scc)) {
+	// a strongly fair transition enabled in the SCC but never fired inside it : only the states
+	// where it is disabled may still hold fair cycles
+	State unfair = State::null;
+	for (strong_fairs_t::const_iterator sit = strong.begin() ; sit != strong.end() ; ++sit) {
+	  if ((scc * sit->enabled) != State::null && (sit->fired (scc) * scc) == State::null)
+	    unfair = unfair + (scc * sit->enabled);
+	}
+	if (unfair == State::null) {
+	  trace << "Fair SCC found after " << nbscc << " SCC." << std::endl;
+	  return scc;
+	}
+	todo.push_back(scc - unfair);
+      }
+
+      todo.push_back(converged - scc);
+      todo.push_back(V - converged);
     }
+    trace << "No fair SCC in " << nbscc << " SCC." << std::endl;
+    return State::null;
+  }
 
-    return findSCC_owcty (getNextByAll(), nextAccs, getInitState());
+  State fsltlModel::runSCCAlgo (scc_algo_t algo, its::Transition nextAll, const trans_t & nextAccs, its::State init, bool decisionOnly,
+				scc_stats_t * stats, bool adaptive) {
+    switch (algo) {
+    case OWCTY :
+      return findSCC_fsltl (nextAll, nextAccs, init, true, decisionOnly, stats, adaptive);
+    case EL :
+      return findSCC_fsltl (nextAll, nextAccs, init, false, decisionOnly, stats, adaptive);
+    case OWCTY_BWD :
+      return findSCC_fsltl_bwd (nextAll, nextAccs, init, true, decisionOnly, stats, adaptive);
+    case EL_BWD :
+      return findSCC_fsltl_bwd (nextAll, nextAccs, init, false, decisionOnly, stats, adaptive);
+    case LOCKSTEP :
+    default :
+      return findSCC_lockstep (nextAll, nextAccs, init);
+    }
   }
 
-  State fsltlModel::findSCC_el () {
-    trans_t nextAccs;
-    for (accToTrans_it accit = accToTrans_.begin() ; accit != accToTrans_.end() ; ++accit ) {
-      nextAccs.push_back(accit->second);
-      trace << "For acceptance condition  :" <<  accit->first << std::endl ;
+  void fsltlModel::buildFairness (State reach) {
+    if (fairBuilt_)
+      return;
+    fairBuilt_ = true;
+    const labels_t & weak = sogIts_->getWeakFairness();
+    for (labels_it it = weak.begin() ; it != weak.end() ; ++it) {
+      State enabled = getEnabled(localApply(sogIts_->getNamedTransition(*it), modelVar()), reach);
+      weakAccs_.push_back(getWeakFairRel(getNextByAll(), fairFired_[*it], enabled, reach));
+      weakNames_.push_back("WF(" + *it + ")");
+    }
+    const labels_t & strong = sogIts_->getStrongFairness();
+    for (labels_it it = strong.begin() ; it != strong.end() ; ++it) {
+      strong_fair_t sf;
+      sf.enabled = getEnabled(localApply(sogIts_->getNamedTransition(*it), modelVar()), reach);
+      sf.fired = fairFired_[*it];
+      strongFair_.push_back(sf);
+      strongNames_.push_back("SF(" + *it + ")");
+    }
+  }
+
+  State fsltlModel::getReach () {
+    if (reach_ != State::null)
+      return reach_;
+    if (! witness_) {
+      reach_ = fixpoint (getNextByAll()  + Transition::id, true) ( getInitState() );
+      return reach_;
+    }
+    Transition nextAll = getNextByAll();
+    reach_ = getInitState();
+    reachLayers_.push_back(reach_);
+    for (;;) {
+      State layer = nextAll (reachLayers_.back()) - reach_;
+      if (layer == State::null)
+	break;
+      reach_ = reach_ + layer;
+      reachLayers_.push_back(layer);
+    }
+    return reach_;
+  }
+
+  labels_t fsltlModel::getAccNames () const {
+    labels_t names;
+    for (accToTrans_t::const_iterator accit = accToTrans_.begin() ; accit != accToTrans_.end() ; ++accit ) {
+      names.push_back(accit->first);
+    }
+    return names;
+  }
+
+  State fsltlModel::runHull (scc_algo_t algo, Transition nextAll, const trans_t & nextAccs, State init, const labels_t & names) {
+    scc_stats_t run;
+    State res = runSCCAlgo (algo, nextAll, nextAccs, init, decisionOnly_, hullStats_ ? &run : nullptr, adaptiveOrder_);
+    stats_.iterations += run.iterations;
+    stats_.closures += run.closures;
+    for (size_t i = 0 ; i < run.removed.size() ; ++i) {
+      stats_.removed[names[i]] += run.removed[i];
+    }
+    return res;
+  }
+
+  State fsltlModel::findSCC (scc_algo_t algo) {
+    stats_ = hull_stats_t();
+    // with witness_, the hulls start from the layered reachable states : their own reachability is then a single pass
+    State init = witness_ ? getReach() : getInitState();
+    if (! isGenBuchi_) {
+      // one generalized Buchi check per acceptance clause, from the states reachable with all arcs
+      State reach = getReach();
+      for (size_t i = 0 ; i < clauses_.size() ; ++i) {
+	trace << "Acceptance clause " << i << std::endl;
+	State res = runHull (algo, clauses_[i].all, clauses_[i].accs, reach, clauses_[i].names);
+	if (res != State::null) {
+	  lastClause_ = i;
+	  return res;
+	}
+      }
+      return State::null;
     }
+    if (! fairFired_.empty()) {
+      // weak fairness adds acceptance relations, strong fairness refines the fair SCC of the result
+      State reach = getReach();
+      buildFairness(reach);
+      trans_t nextAccs;
+      for (accToTrans_it accit = accToTrans_.begin() ; accit != accToTrans_.end() ; ++accit ) {
+	nextAccs.push_back(accit->second);
+      }
+      nextAccs.insert(nextAccs.end(), weakAccs_.begin(), weakAccs_.end());
+      labels_t names = getAccNames();
+      names.insert(names.end(), weakNames_.begin(), weakNames_.end());
+      State res = runHull (algo, getNextByAll(), nextAccs, init, names);
+      if (res == State::null || strongFair_.empty())
+	return res;
+      return findSCC_lockstep (getNextByAll(), nextAccs, res, strongFair_);
+    }
+    if (! sccBuilt_) {
+      trans_t nextAccs;
+      for (accToTrans_it accit = accToTrans_.begin() ; accit != accToTrans_.end() ; ++accit ) {
+	nextAccs.push_back(accit->second);
+	trace << "For acceptance condition  :" <<  accit->first << std::endl ;
+      }
+      return runHull (algo, getNextByAll(), nextAccs, init, getAccNames());
+    }
+
+    // reachability once, with all arcs
+    State reach = getReach();
+    State res = State::null;
+    for (std::map<int, Transition>::const_iterator it = sccTrans_.begin() ; it != sccTrans_.end() ; ++it) {
+      // the reachable states whose automaton state is in this SCC
+      State init = localApply(tgba_->getSCCSelector(it->first), tgbaVar()) (reach);
+      if (init == State::null)
+	continue;
+      trace << "Automaton SCC " << it->first << " with nbstates= " << init.nbStates() << std::endl;
+      accToTrans_t & sccAccs = sccAccToTrans_[it->first];
+      trans_t nextAccs;
+      for (accToTrans_it accit = accToTrans_.begin() ; accit != accToTrans_.end() ; ++accit ) {
+	accToTrans_it sccit = sccAccs.find(accit->first);
+	nextAccs.push_back(sccit == sccAccs.end() ? Transition::null : sccit->second);
+      }
+      res = runHull (algo, it->second, nextAccs, init, getAccNames());
+      if (res != State::null) {
+	// an accepting cycle exists, other SCC are irrelevant
+	return res;
+      }
+    }
+    return res;
+  }
 
-    return findSCC_el (getNextByAll(), nextAccs, getInitState());
+  State fsltlModel::findSCC_owcty () {
+    return findSCC (OWCTY);
+  }
+
+  State fsltlModel::findSCC_el () {
+    return findSCC (EL);
+  }
+
+  State fsltlModel::findSCC_owcty_bwd () {
+    return findSCC (OWCTY_BWD);
+  }
+
+  State fsltlModel::findSCC_el_bwd () {
+    return findSCC (EL_BWD);
+  }
+
+  State fsltlModel::findSCC_lockstep () {
+    return findSCC (LOCKSTEP);
   }
 
 
@@ -185,6 +742,230 @@ namespace its {
     return findSCC_fsltl (nextAll, nextAccs, init, false);
   }
 
+  State fsltlModel::findSCC_owcty_bwd (its::Transition nextAll, const trans_t & nextAccs, its::State init) {
+    return findSCC_fsltl_bwd (nextAll, nextAccs, init, true);
+  }
+
+  State fsltlModel::findSCC_el_bwd (its::Transition nextAll, const trans_t & nextAccs, its::State init) {
+    return findSCC_fsltl_bwd (nextAll, nextAccs, init, false);
+  }
+
 
 
+  
+
+  // Shortest path inside set, from the single state src to some state of target.
+  // Returns the sequence of single states visited, src first, or an empty path if target is not reachable.
+  // The onion rings of the forward search are kept, then walked back with pre-images.
+  static std::vector<State> findPath (Transition next, Transition pre, const State & set, const State & src, const State & target) {
+    std::vector<State> rings;
+    rings.push_back(src);
+    State visited = src;
+    while ((rings.back() * target) == State::null) {
+      State ring = (next (rings.back()) * set) - visited;
+      if (ring == State::null)
+	return std::vector<State>();
+      visited = visited + ring;
+      rings.push_back(ring);
+    }
+    std::vector<State> path (rings.size());
+    path.back() = fsltlModel::pickOne(rings.back() * target);
+    for (int i = rings.size() - 2 ; i >= 0 ; --i) {
+      path[i] = fsltlModel::pickOne(pre (path[i+1]) * rings[i]);
+    }
+    return path;
+  }
+
+  // The product state is State(1, tgba, State(0, model)), or State(1, model, State(0, tgba)).
+  State fsltlModel::getModelPart (const State & s) const {
+    if (s == State::null || s == State::one || s == State::top)
+      return s;
+    const GSDD * node = &s;
+    if (modelVar() == 0) {
+      node = &s.begin()->second;
+      if (*node == GSDD::null || *node == GSDD::one || *node == GSDD::top)
+	return s;
+    }
+    const SDD * model = dynamic_cast<const SDD *>(node->begin()->first);
+    return model ? State(*model) : s;
+  }
+
+  std::string fsltlModel::getModelStepName (const State & msrc, const State & mdst) const {
+    Type::namedTrs_t ntrans;
+    sogIts_->getType()->getNamedLocals(ntrans);
+    for (Type::namedTrs_t::const_iterator it = ntrans.begin() ; it != ntrans.end() ; ++it) {
+      if ((it->second (msrc) * mdst) != State::null)
+	return it->first;
+    }
+    return "";
+  }
+
+  // Forward rings from the successors of msrc until one meets mdst, then walked back with pre-images.
+  labels_t fsltlModel::expandSaturated (Transition stutter, const State & msrc, const State & mdst) const {
+    std::vector<State> rings;
+    rings.push_back(msrc);
+    State visited = State::null;
+    do {
+      State ring = stutter (rings.back()) - visited;
+      if (ring == State::null)
+	return labels_t();
+      visited = visited + ring;
+      rings.push_back(ring);
+    } while ((rings.back() * mdst) == State::null);
+    Transition pre = stutter.invert(visited + msrc);
+    std::vector<State> path (rings.size());
+    path.back() = pickOne(rings.back() * mdst);
+    for (int i = rings.size() - 2 ; i >= 0 ; --i) {
+      path[i] = pickOne(pre (path[i+1]) * rings[i]);
+    }
+    labels_t names;
+    for (size_t i = 0 ; i + 1 < path.size() ; ++i) {
+      std::string name = getModelStepName(path[i], path[i+1]);
+      names.push_back(name.empty() ? "[?]" : name);
+    }
+    return names;
+  }
+
+  std::string fsltlModel::getStepName (const State & src, const State & dst) const {
+    State msrc = getModelPart(src);
+    State mdst = getModelPart(dst);
+    std::string name = getModelStepName(msrc, mdst);
+    if (! name.empty())
+      return name;
+    // several model steps under the self loops of the automaton state of src
+    for (size_t i = 0 ; i < stutterSteps_.size() ; ++i) {
+      if (stutterSteps_[i].first (src) == State::null)
+	continue;
+      labels_t steps = expandSaturated(stutterSteps_[i].second, msrc, mdst);
+      for (labels_it it = steps.begin() ; it != steps.end() ; ++it)
+	name += (it == steps.begin() ? "" : ", ") + *it;
+      if (! name.empty())
+	return name;
+    }
+    if (msrc == mdst)
+      return "[stutter]";
+    return "[?]";
+  }
+
+  bool fsltlModel::printWitness (const State & res, bool isForwardHull, std::ostream & os) {
+    trans_t nextAccs;
+    std::vector<std::string> accNames;
+    Transition nextAll = getNextByAll();
+    // computed by findSCC
+    State reach = getReach();
+    if (isGenBuchi_) {
+      for (accToTrans_it accit = accToTrans_.begin() ; accit != accToTrans_.end() ; ++accit ) {
+	nextAccs.push_back(accit->second);
+	accNames.push_back(accit->first);
+      }
+      nextAccs.insert(nextAccs.end(), weakAccs_.begin(), weakAccs_.end());
+      accNames.insert(accNames.end(), weakNames_.begin(), weakNames_.end());
+    } else {
+      // the lasso lives in the clause that found it; the prefix may use any arc
+      nextAccs = clauses_[lastClause_].accs;
+      accNames = clauses_[lastClause_].names;
+    }
+    // the relation used inside the fair SCC
+    Transition cycleAll = isGenBuchi_ ? nextAll : clauses_[lastClause_].all;
+    Transition preAll = nextAll.invert(reach);
+    Transition cyclePre = isGenBuchi_ ? preAll : cycleAll.invert(reach);
+
+    // Find a fair SCC inside res : climb (forward hull) or descend (backward hull) the SCC graph of res.
+    State scc = State::null;
+    State seed = pickOne(res);
+    while (seed != State::null) {
+      State fwd = seed;
+      State bwd = seed;
+      for (State front = seed ; front != State::null ; fwd = fwd + front) {
+	front = (cycleAll (front) * res) - fwd;
+      }
+      for (State front = seed ; front != State::null ; bwd = bwd + front) {
+	front = (cyclePre (front) * res) - bwd;
+      }
+      State cand = fwd * bwd;
+      if (isFairSCC (cycleAll, nextAccs, cand)) {
+	scc = cand;
+	break;
+      }
+      seed = pickOne(isForwardHull ? bwd - cand : fwd - cand);
+    }
+    if (scc == State::null) {
+      std::cerr << "Could not locate a fair SCC to build a witness." << std::endl;
+      return false;
+    }
+    // the cycle also fires the strongly fair transitions enabled in the SCC
+    for (size_t i = 0 ; isGenBuchi_ && i < strongFair_.size() ; ++i) {
+      if ((scc * strongFair_[i].enabled) != State::null) {
+	nextAccs.push_back(strongFair_[i].fired);
+	accNames.push_back(strongNames_[i]);
+      }
+    }
+
+    // prefix : from the initial states to the SCC, walking back the layers of the reachable states
+    std::vector<State> prefix;
+    if (reachLayers_.empty()) {
+      // findSCC ran without setWitness
+      prefix = findPath (nextAll, preAll, reach, pickOne(getInitState()), scc);
+    } else {
+      size_t depth = 0;
+      while (depth < reachLayers_.size() && (reachLayers_[depth] * scc) == State::null)
+	++depth;
+      if (depth < reachLayers_.size()) {
+	prefix.resize(depth + 1);
+	prefix[depth] = pickOne(reachLayers_[depth] * scc);
+	for (int i = depth - 1 ; i >= 0 ; --i) {
+	  prefix[i] = pickOne(preAll (prefix[i+1]) * reachLayers_[i]);
+	}
+      }
+    }
+    if (prefix.empty()) {
+      std::cerr << "Could not reach the fair SCC to build a witness." << std::endl;
+      return false;
+    }
+
+    // cycle : visit an arc of each acceptance condition, then come back
+    State start = prefix.back();
+    std::vector<State> cycle;
+    cycle.push_back(start);
+    for (trans_it accit = nextAccs.begin(); accit != nextAccs.end() ; ++accit) {
+      State sources = accit->invert(reach) (scc) * scc;
+      std::vector<State> path = findPath (cycleAll, cyclePre, scc, cycle.back(), sources);
+      if (path.empty())
+	return false;
+      cycle.insert(cycle.end(), path.begin() + 1, path.end());
+      cycle.push_back(pickOne((*accit) (cycle.back()) * scc));
+    }
+    if (cycle.size() == 1) {
+      // no acceptance condition, any step in the SCC will do
+      cycle.push_back(pickOne(cycleAll (start) * scc));
+    }
+    std::vector<State> back = findPath (cycleAll, cyclePre, scc, cycle.back(), start);
+    if (back.empty())
+      return false;
+    cycle.insert(cycle.end(), back.begin() + 1, back.end());
+
+    pType modelType = sogIts_->getType();
+    os << "Prefix:" << std::endl;
+    for (size_t i = 0 ; i + 1 < prefix.size() ; ++i) {
+      os << "  ";
+      modelType->printState(getModelPart(prefix[i]), os, 1);
+      os << "  |  " << getStepName(prefix[i], prefix[i+1]) << std::endl;
+    }
+    os << "Cycle:" << std::endl;
+    for (size_t i = 0 ; i + 1 < cycle.size() ; ++i) {
+      os << "  ";
+      modelType->printState(getModelPart(cycle[i]), os, 1);
+      os << "  |  " << getStepName(cycle[i], cycle[i+1]);
+      bool first = true;
+      for (size_t j = 0 ; j < nextAccs.size() ; ++j) {
+	if ((nextAccs[j] (cycle[i]) * cycle[i+1]) != State::null) {
+	  os << (first ? "\t{" : ",") << accNames[j];
+	  first = false;
+	}
+      }
+      os << (first ? "" : "}") << std::endl;
+    }
+    return true;
   }
+
+}
@@ -28,20 +28,115 @@ namespace its {
 
     Transition getNextByAcc (Label acc) ;
 
+    // The model part of a single state of the product.
+    State getModelPart (const State & s) const;
+    // The name of a model transition leading from src to dst, both single states of the product.
+    // A saturated step is expanded into the names of the model transitions it fires.
+    std::string getStepName (const State & src, const State & dst) const;
+    // The name of a model transition leading from msrc to mdst, both single states of the model, or empty.
+    std::string getModelStepName (const State & msrc, const State & mdst) const;
+    // The names of a shortest sequence of at least one model step of stutter, from msrc to mdst.
+    labels_t expandSaturated (Transition stutter, const State & msrc, const State & mdst) const;
+
     typedef std::map<std::string,Transition> accToTrans_t;
     typedef accToTrans_t::iterator accToTrans_it;
     accToTrans_t accToTrans_;
 
+    // stop as soon as a fair SCC is found, instead of computing the whole hull
+    bool decisionOnly_;
+
+    // the encoding of the automaton state
+    TgbaType::encoding_t tgbaEncoding_;
+    // true if the automaton variable is above the model variable in the product
+    bool tgbaOnTop_;
+    // the SDD variable of each component in the product
+    int tgbaVar () const { return tgbaOnTop_ ? 1 : 0; }
+    int modelVar () const { return tgbaOnTop_ ? 0 : 1; }
+
+    // false if the acceptance condition uses Fin, or is not a conjunction of Inf
+    bool isGenBuchi_;
+    // A clause Fin(F) & Inf(I) of the acceptance condition in DNF, as relations restricted to arcs without marks in F.
+    struct acc_clause_t {
+      // all the arcs without marks in F
+      Transition all;
+      // for each set of I, the arcs of all that bear it
+      std::vector<Transition> accs;
+      // the names of the sets of I
+      labels_t names;
+    };
+    std::vector<acc_clause_t> clauses_;
+    // the index of the clause that found the last accepting cycle
+    size_t lastClause_;
+    // build clauses_, for automata that are not generalized Buchi
+    void buildAcceptanceClauses (Transition modelRel);
+
+    // run the SCC algorithms separately on each accepting SCC of the automaton
+    bool sccDecomposition_;
+    // true once the per automaton SCC relations below are built
+    bool sccBuilt_;
+    // for each accepting automaton SCC, the product transitions using only arcs inside it
+    std::map<int, Transition> sccTrans_;
+    // for each accepting automaton SCC, the same split as accToTrans_
+    std::map<int, accToTrans_t> sccAccToTrans_;
+
+    // encode the automaton self loops as saturated model steps
+    bool stutterSaturation_;
+    // collect hull statistics in stats_
+    bool hullStats_;
+    // reorder the closures of the hull by the number of states they remove
+    bool adaptiveOrder_;
+    // with stutter saturation, for each automaton state with self loops, its selector in the product
+    // and the model steps its self loops allow
+    std::vector<std::pair<Transition, Transition> > stutterSteps_;
+
+    // keep the breadth first layers of the reachable states, for printWitness
+    bool witness_;
+    // the reachable states of the product, and with witness_ their breadth first layers
+    State reach_;
+    std::vector<State> reachLayers_;
+    // the reachable states of the product, computed once per automaton
+    State getReach ();
+
   public :
     // ctor
-    fsltlModel() : tgba_(NULL), sogIts_(NULL), allTrans_(Transition::null) {};
+    fsltlModel() : tgba_(NULL), sogIts_(NULL), allTrans_(Transition::null), decisionOnly_(false), tgbaEncoding_(TgbaType::INTEGER), tgbaOnTop_(true), isGenBuchi_(true), lastClause_(0), sccDecomposition_(false), sccBuilt_(false), stutterSaturation_(false), hullStats_(false), adaptiveOrder_(true), witness_(false), reach_(State::null), fairBuilt_(false) {};
 
     void setSogModel ( sogIts * sogits) { sogIts_ = sogits ; }
 
+    // In decision only mode, the SCC algorithms return a fair SCC as soon as one is certain,
+    // rather than the set of all accepting states + suffixes.
+    void setDecisionOnly (bool val) { decisionOnly_ = val; }
+
+    // Choose how the automaton state is encoded, and whether it is placed above (default) or below the model
+    // in the product. Must be set before declareType.
+    void setTgbaEncoding (TgbaType::encoding_t encoding) { tgbaEncoding_ = encoding; }
+    void setTgbaOnTop (bool val) { tgbaOnTop_ = val; }
+
+    // Compute reachability once, then run the SCC algorithm on each accepting SCC of the automaton in turn,
+    // with only the arcs inside that SCC. Must be set before buildComposedSystem.
+    void setSCCDecomposition (bool val) { sccDecomposition_ = val; }
+
+    // A stretch of model steps that keeps the automaton in the same state through self loops becomes
+    // a single product step, computed by saturation on the model only. Pays off for stutter insensitive formulas.
+    // Must be set before buildComposedSystem.
+    void setStutterSaturation (bool val) { stutterSaturation_ = val; }
+
+    // Collect the statistics of the hulls, see getLastStats.
+    void setHullStats (bool val) { hullStats_ = val; }
+
+    // Apply first the closures of the hull that removed the most states in the previous iteration (default).
+    // Both this and setHullStats count the states of the hull after each closure.
+    void setAdaptiveOrder (bool val) { adaptiveOrder_ = val; }
+
+    // Compute the reachable states by breadth first layers rather than by saturation, so that
+    // printWitness builds its prefix from them. Must be set before findSCC.
+    void setWitness (bool val) { witness_ = val; }
+
     // Play factory role for building ITS types from other formalisms
     // Returns false and aborts if type name already exists.
     // Create a type to hold a spot TGBA
-    bool declareType (spot::const_twa_ptr tgba);
+    // The relations built for a previous automaton are forgotten, so that the model can check several formulas.
+    virtual bool declareType (spot::const_twa_ptr tgba);
 
     // Build the composed system based on the TGBA and the main instance of the ITSModel.
     // Precondition : we have built a model, invoked setInstance and setInstanceState, and declared a TGBA type.
@@ -51,17 +146,52 @@ namespace its {
     bool buildComposedSystem ();
 
 
+    /// The fully symbolic SCC algorithms available.
+    enum scc_algo_t { OWCTY, EL, OWCTY_BWD, EL_BWD, LOCKSTEP };
+
+    /// Run an SCC algorithm with member data, on the whole product or per accepting automaton SCC.
+    State findSCC (scc_algo_t algo);
+
     /// calls static operation with member data.
     State findSCC_owcty();
 
     /// calls static operation with member data.
     State findSCC_el();
 
+    /// calls static operation with member data.
+    State findSCC_owcty_bwd();
+
+    /// calls static operation with member data.
+    State findSCC_el_bwd();
+
+    /// calls static operation with member data.
+    State findSCC_lockstep();
+
 
     /// to represent a set of transition relations as passed to findSCC algorithm.
     typedef std::vector<its::Transition> trans_t;
     typedef trans_t::const_iterator trans_it;
 
+    /// Statistics of a hull computation, for tuning.
+    struct scc_stats_t {
+      // number of iterations of the outer loop
+      int iterations;
+      // number of closure applications
+      int closures;
+      // number of states removed by the closure of each acceptance relation, by index in nextAccs
+      std::vector<double> removed;
+      scc_stats_t () : iterations(0), closures(0) {}
+    };
+
+    /// Statistics of the hulls of a findSCC, summed over clauses and automaton SCC.
+    struct hull_stats_t {
+      int iterations;
+      int closures;
+      // number of states removed by the closure of each acceptance set, by label
+      std::map<std::string, double> removed;
+      hull_stats_t () : iterations(0), closures(0) {}
+    };
+
     /// Verify whether there are accepting paths in the product.
     /// Precondition : buildComposedSystem has been invoked.
     /// Returns the set of accepting states + suffix.
@@ -79,10 +209,100 @@ namespace its {
     static State findSCC_el (its::Transition nextAll, const trans_t & nextAccs, its::State init);
 
 
-    /** Delegate to the appropriate variant of fsltl. */
-    static State findSCC_fsltl (its::Transition nextAll, const trans_t & nextAccs, its::State init, bool isOWCTY);
+    /** Delegate to the algorithm designated by algo. */
+    /** If stats is not null, the hull statistics are added to it. */
+    /** If adaptive is set, the hull applies first the closures that removed the most states. */
+    static State runSCCAlgo (scc_algo_t algo, its::Transition nextAll, const trans_t & nextAccs, its::State init, bool decisionOnly,
+			     scc_stats_t * stats = nullptr, bool adaptive = true);
 
+    /** Delegate to the appropriate variant of fsltl.
+     *  If decisionOnly is set, after each iteration of the hull a seed state is probed, with a bounded number of steps :
+     *  if it lies on a fair cycle, its SCC is returned immediately.
+     *  If stats is not null, the hull statistics are added to it.
+     *  If adaptive is set, the hull applies first the closures that removed the most states. */
+    static State findSCC_fsltl (its::Transition nextAll, const trans_t & nextAccs, its::State init, bool isOWCTY, bool decisionOnly = false,
+				scc_stats_t * stats = nullptr, bool adaptive = true);
 
+    /// Backward variant of findSCC_owcty : the same hull computation, using pre-images.
+    /// Returns the set of states that can reach an accepting cycle (prefix + accepting states).
+    static State findSCC_owcty_bwd (its::Transition nextAll, const trans_t & nextAccs, its::State init);
+
+    /// Backward variant of findSCC_el : Emerson-Lei with pre-images.
+    /// Returns the set of states that can reach an accepting cycle (prefix + accepting states).
+    static State findSCC_el_bwd (its::Transition nextAll, const trans_t & nextAccs, its::State init);
+
+    /** Delegate to the appropriate variant of backward fsltl.
+     *  If stats is not null, the hull statistics are added to it.
+     *  If adaptive is set, the hull applies first the closures that removed the most states. */
+    static State findSCC_fsltl_bwd (its::Transition nextAll, const trans_t & nextAccs, its::State init, bool isOWCTY, bool decisionOnly = false,
+				    scc_stats_t * stats = nullptr, bool adaptive = true);
+
+    /// A strong fairness constraint on a model transition.
+    struct strong_fair_t {
+      // the states where the transition is enabled
+      State enabled;
+      // the steps that fire it
+      Transition fired;
+    };
+    typedef std::vector<strong_fair_t> strong_fairs_t;
+
+    /// Verify whether there are accepting paths in the product.
+    /// Algorithm used is the lockstep SCC decomposition
+    /// see [FMCAD2000 - An algorithm for strongly connected component analysis in n log n symbolic steps - Bloem et al.]
+    /// An SCC that enables a strongly fair transition without firing it is refined by removing the states that enable it.
+    /// Returns the first fair SCC found, or null.
+    static State findSCC_lockstep (its::Transition nextAll, const trans_t & nextAccs, its::State init,
+				   const strong_fairs_t & strong = strong_fairs_t());
+
+    /// The states of reach in which t can fire.
+    static State getEnabled (its::Transition t, its::State reach);
+
+    /// The acceptance relation of a weakly fair transition : the steps that fire it, and the steps of nextAll
+    /// that leave a state of reach where it is disabled.
+    static Transition getWeakFairRel (its::Transition nextAll, its::Transition fired, its::State enabled, its::State reach);
+
+    /// True if the set scc, assumed strongly connected, holds a cycle and an arc of each acceptance condition.
+    static bool isFairSCC (its::Transition nextAll, const trans_t & nextAccs, const State & scc);
+
+    /// Extract and print an accepting lasso of the product, as model states and names of the transitions fired.
+    /// res is the result of one of the findSCC variants : isForwardHull is true if it was computed with images
+    /// (its top SCC are fair), false if it was computed with pre-images (its bottom SCC are fair).
+    /// Returns false if no lasso could be built.
+    bool printWitness (const State & res, bool isForwardHull, std::ostream & os);
+
+    /// Pick a single state in a non empty set of states.
+    /// Only SDD and DDD arc values can be split, other data sets are kept whole,
+    /// so the result may hold more than one state.
+    static State pickOne (const State & s);
+
+    /// Statistics of the hulls computed by the last findSCC on this model, empty unless setHullStats.
+    const hull_stats_t & getLastStats () const { return stats_; }
+
+  private :
+    // The nested fixpoint loop shared by forward and backward hulls, accumulates into stats if not null.
+    // States are only counted if adaptive or stats is set.
+    static State hullLoop (Transition trim, const trans_t & closures, State div, bool decisionOnly,
+			   Transition nextAll, Transition preAll, const trans_t & nextAccs, bool adaptive, scc_stats_t * stats);
+
+  protected :
+    // statistics of the last findSCC
+    hull_stats_t stats_;
+    // the labels of accToTrans_, in the order of its relations
+    labels_t getAccNames () const;
+    // runSCCAlgo with member options, adds its statistics to stats_ under the labels names of nextAccs
+    State runHull (scc_algo_t algo, Transition nextAll, const trans_t & nextAccs, State init, const labels_t & names);
+    // for each fair model transition, the product steps that fire it
+    std::map<std::string, Transition> fairFired_;
+    // true once the relations below are built
+    bool fairBuilt_;
+    // one acceptance relation per weakly fair transition, and their names
+    trans_t weakAccs_;
+    labels_t weakNames_;
+    // the strong fairness constraints, and their names
+    strong_fairs_t strongFair_;
+    labels_t strongNames_;
+    // build the fairness relations, they depend on the reachable states
+    void buildFairness (State reach);
   };
 
 
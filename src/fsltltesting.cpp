@@ -67,18 +67,17 @@ namespace its
 
     for (labels_it it = tgbalabs.begin(); it != tgbalabs.end(); ++it)
       {
-        TgbaType::tgba_arc_label_t arcLab =
-            tgba_->getTransLabelDescription(*it);
-
         // in TGTA, change_set = (source_state_condition) XOR (destination_state_condition)
-        bdd change_set = arcLab.first;
+        bdd change_set = tgba_->getTransLabelCondition(*it);
         all_changesets.insert(change_set);
       }
 
     //Statistic sB(initState_, "*** Before compute_transitions_by_changesets");
     //sB.print_line(std::cerr);
-    model_labled_by_changesets_->compute_transitions_by_changesets(
-        all_changesets);
+    // other models build their changeset relations symbolically, see sogIts::getNextByChangeSet
+    if (model_labled_by_changesets_)
+      model_labled_by_changesets_->compute_transitions_by_changesets(
+          all_changesets);
 
     //Statistic sA(initState_, "*** After compute_transitions_by_changesets");
     //	sA.print_line(std::cerr);
@@ -87,41 +86,42 @@ namespace its
       {
         trace
           << "label :" << *it << std::endl;
-        TgbaType::tgba_arc_label_t arcLab =
-            tgba_->getTransLabelDescription(*it);
-        trace
-          << "desc :" << arcLab.first << ":" << arcLab.second << std::endl;
-
         labels_t labtodo;
         labtodo.push_back(*it);
 
         // in TGTA, change_set = (source_state_condition) XOR (destination_state_condition)
-        bdd change_set = arcLab.first;
+        bdd change_set = tgba_->getTransLabelCondition(*it);
+        trace
+          << "desc :" << change_set << std::endl;
 
-        Transition model_transition =
-            model_labled_by_changesets_->getLocalsByChangeSet(change_set);
+        Transition model_transition = model_labled_by_changesets_
+            ? model_labled_by_changesets_->getLocalsByChangeSet(change_set)
+            : sogIts_->getNextByChangeSet(change_set);
 
-        Transition toadd = localApply(tgba_->getSuccs(labtodo), 1)
-            & localApply(model_transition, 0);
+        Transition toadd = localApply(tgba_->getSuccs(labtodo), tgbaVar())
+            & localApply(model_transition, modelVar());
 
         if ((bdd_setxor(change_set, change_set) == change_set))
           allStutteringTrans_ = allStutteringTrans_ + (localApply(
-              Transition::id, 1) & localApply(model_transition, 0));
+              Transition::id, tgbaVar()) & localApply(model_transition, modelVar()));
         else
           allTrans_ = allTrans_ + toadd;
 
-        labels_t accs = tgba_->getAcceptanceSet(arcLab.second);
+        labels_t accs = tgba_->getTransLabelAcceptance(*it);
         for (labels_it acc = accs.begin(); acc != accs.end(); ++acc)
           {
+            // only the arcs of this condition that bear the acceptance set
+            Transition accadd = localApply(tgba_->getSuccsByAcc(*it, *acc), tgbaVar())
+                & localApply(model_transition, modelVar());
             accToTrans_it accit = accToTrans_.find(*acc);
             if (accit == accToTrans_.end())
               {
                 // first occurrence
-                accToTrans_[*acc] = toadd;
+                accToTrans_[*acc] = accadd;
               }
             else
               {
-                accit->second = accit->second + toadd;
+                accit->second = accit->second + accadd;
               }
           }
       }
@@ -129,6 +129,15 @@ namespace its
     return true;
   }
 
+  bool
+  fsltlTestingModel::declareType(spot::const_twa_ptr tgba)
+  {
+    // the initial states and stuttering steps depend on the automaton
+    initState_ = State::null;
+    allStutteringTrans_ = Transition::null;
+    return fsltlModel::declareType(tgba);
+  }
+
   State
   fsltlTestingModel::getInitState()
   {
@@ -143,23 +152,22 @@ namespace its
           {
             trace
               << "label :" << *it << std::endl;
-            TgbaType::tgba_arc_label_t arcLab =
-                tgba_->getTransLabelDescription(*it);
+            bdd cond = tgba_->getTransLabelCondition(*it);
             trace
-              << "desc :" << arcLab.first << ":" << arcLab.second << std::endl;
-            Transition apcond = sogIts_->getSelector(arcLab.first,
+              << "desc :" << cond << std::endl;
+            Transition apcond = sogIts_->getSelector(cond,
                 getInstance()->getType());
 
             labels_t labtodo;
             labtodo.push_back(*it);
-            Transition toadd = localApply(tgba_->getSuccs(labtodo), 1)
-                & localApply(apcond, 0);
+            Transition toadd = localApply(tgba_->getSuccs(labtodo), tgbaVar())
+                & localApply(apcond, modelVar());
 
             allTrans = allTrans + toadd;
           }
 
-        initState_ = allTrans(State(1, findType("TGBA")->getState("init"),
-            State(0, getInstance()->getType()->getState("init"))));
+        // the layout of the product, as set by setTgbaOnTop
+        initState_ = allTrans(fsltlModel::getInitState());
 
       }
 
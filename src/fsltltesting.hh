@@ -31,6 +31,9 @@ namespace its
     virtual bool
     declareETFType(Label path);
 
+    virtual bool
+    declareType(spot::const_twa_ptr tgba);
+
     virtual State
     getInitState();
 
@@ -26,6 +26,7 @@
 #include <sstream>
 #include <string>
 #include <cstring>
+#include <cstdlib>
 
 #include <bddx.h>
 #include <spot/tl/parse.hh>
@@ -70,7 +71,7 @@ void usage() {
 			<< std::endl << "Actions:" << std::endl
 			<< "  -aALGO          apply the emptiness check algoritm ALGO"
 			<< std::endl
-			<< "  -SSOGTYPE       apply the SOG construction algoritm SOGTYPE={SOG,SLAP,SOP,FSOWCTY,FSOWCTY-TGTA,FSEL,BCZ99,SLAP-FST,SLAP-FSA} (SLAP-FST by default)\n"
+			<< "  -SSOGTYPE       apply the SOG construction algoritm SOGTYPE={SOG,SLAP,SOP,FSOWCTY,FSOWCTY-TGTA,FSEL,FSOWCTY-BWD,FSEL-BWD,FSLOCKSTEP,BCZ99,SLAP-FST,SLAP-FSA} (SLAP-FST by default)\n"
 			<< "                  The FST variants include a test for switching to fully symbolic emptiness check in terminal states.\n"
 			<< "                  The FSA variants include a test for switching to fully symbolic emptiness check in any potentially accepting automaton state."
 			<< std::endl
@@ -84,6 +85,36 @@ void usage() {
 			<< "  -p              display the net" << std::endl
 			<< "  -s              show the formula automaton" << std::endl
 			<< "  -stutter-deadlock              stutter in deadlock states"
+			<< std::endl
+			<< "  --sog-cache DIR  store fully built observation graphs (SOG and BCZ99 variants) in folder DIR, and reuse them in later runs on the same model file and AP set.\n"
+			<< "                  A run that misses the cache builds the whole graph before the check, losing the early exit on violated properties.\n"
+			<< "                  Only for models held in a single file : PROD, CAMI, ETF and DVE."
+			<< std::endl
+			<< "  --coi           cone of influence reduction : drop transitions that cannot influence the atomic propositions of the formula"
+			<< std::endl
+			<< "  --fs-decision   fully symbolic variants stop as soon as an accepting cycle is found (the reported set is then a single fair SCC)"
+			<< std::endl
+			<< "  --fs-scc        fully symbolic variants run separately on each accepting SCC of the automaton"
+			<< std::endl
+			<< "  --fs-encoding ENC  encoding of the automaton state in fully symbolic variants ENC={int,binary,onehot} (int by default)"
+			<< std::endl
+			<< "  --fs-tgba-pos POS  position of the automaton in the fully symbolic product POS={top,bottom} (top by default)"
+			<< std::endl
+			<< "  --fs-stutter    fully symbolic variants saturate the model steps that follow an automaton self loop"
+			<< std::endl
+			<< "  --fs-stats      fully symbolic variants print the iterations of their hulls, and the states removed by each acceptance set"
+			<< std::endl
+			<< "  --fs-fixed-order  fully symbolic hulls apply the acceptance sets in a fixed order, instead of the one that removed the most states first"
+			<< std::endl
+			<< "  --weak-fair T   model transition T is weakly fair : it cannot stay enabled forever without firing (repeatable, fully symbolic and SLAP-FST/SLAP-FSA variants)"
+			<< std::endl
+			<< "  --strong-fair T  model transition T is strongly fair : it cannot be enabled infinitely often without firing (repeatable, fully symbolic and SLAP-FST/SLAP-FSA variants)"
+			<< std::endl
+			<< "  --swarm N       run the explicit emptiness check in N processes, each exploring the product in its own random order"
+			<< std::endl
+			<< "  --scc-parallel N  check SLAP and SOP products by automaton SCC, each entry aggregate of an SCC in one of N processes"
+			<< std::endl
+			<< "  --fs-parity     fully symbolic variants use a parity automaton instead of a TGBA (automata given with -hoa may use any Fin/Inf acceptance)"
 			<< std::endl << "Options of the formula transformation:"
 			<< std::endl << "  -dR3            disable the SCC reduction"
 			<< std::endl << "  -R3f            enable full SCC reduction"
@@ -119,6 +150,19 @@ int main(int argc, const char *argv[]) {
 		bool fair_loop_approx = false;
 		bool print_formula_tgba = false;
 		bool stutter_dead = false;
+		bool coi = false;
+		bool fs_decision = false;
+		bool fs_scc = false;
+		its::TgbaType::encoding_t fs_encoding = its::TgbaType::INTEGER;
+		bool fs_tgba_top = true;
+		bool fs_parity = false;
+		bool fs_stutter = false;
+		bool fs_stats = false;
+		bool fs_fixed_order = false;
+		unsigned swarm = 0;
+		unsigned scc_parallel = 0;
+		its::labels_t weak_fair;
+		its::labels_t strong_fair;
 
 		bool scc_optim = true;
 		bool scc_optim_full = false;
@@ -133,6 +177,8 @@ int main(int argc, const char *argv[]) {
 
 		bool isPlaceSyntax = false;
 
+		std::string sog_cache_dir;
+
 		// echo options of run
 		std::cout << "its-ltl command run as :\n" << std::endl;
 		for (int i = 0; i < argc; i++) {
@@ -184,6 +230,104 @@ int main(int argc, const char *argv[]) {
 				scc_optim_full = true;
 			} else if (!strcmp(args[i], "--place-syntax")) {
 				isPlaceSyntax = true;
+			} else if (!strcmp(args[i], "--coi")) {
+				coi = true;
+			} else if (!strcmp(args[i], "--fs-decision")) {
+				fs_decision = true;
+			} else if (!strcmp(args[i], "--fs-scc")) {
+				fs_scc = true;
+			} else if (!strcmp(args[i], "--fs-encoding")) {
+				if (++i >= argc) {
+					cerr << "give argument value for automaton encoding please after "
+							<< args[i - 1] << endl;
+					usage();
+					exit(1);
+				}
+				if (!strcmp(args[i], "int")) {
+					fs_encoding = its::TgbaType::INTEGER;
+				} else if (!strcmp(args[i], "binary")) {
+					fs_encoding = its::TgbaType::BINARY;
+				} else if (!strcmp(args[i], "onehot")) {
+					fs_encoding = its::TgbaType::ONEHOT;
+				} else {
+					cerr << "Unknown automaton encoding " << args[i] << endl;
+					usage();
+					exit(1);
+				}
+			} else if (!strcmp(args[i], "--weak-fair") || !strcmp(args[i], "--strong-fair")) {
+				if (++i >= argc) {
+					cerr << "give argument value for transition name please after "
+							<< args[i - 1] << endl;
+					usage();
+					exit(1);
+				}
+				if (!strcmp(args[i - 1], "--weak-fair")) {
+					weak_fair.push_back(args[i]);
+				} else {
+					strong_fair.push_back(args[i]);
+				}
+			} else if (!strcmp(args[i], "--fs-stutter")) {
+				fs_stutter = true;
+			} else if (!strcmp(args[i], "--fs-stats")) {
+				fs_stats = true;
+			} else if (!strcmp(args[i], "--fs-fixed-order")) {
+				fs_fixed_order = true;
+			} else if (!strcmp(args[i], "--swarm")) {
+				if (++i >= argc) {
+					cerr << "give argument value for number of swarm workers please after "
+							<< args[i - 1] << endl;
+					usage();
+					exit(1);
+				}
+				char * end;
+				long n = strtol(args[i], &end, 10);
+				if (*end != '\0' || n < 1) {
+					cerr << "Invalid number of swarm workers " << args[i] << endl;
+					usage();
+					exit(1);
+				}
+				swarm = n;
+			} else if (!strcmp(args[i], "--scc-parallel")) {
+				if (++i >= argc) {
+					cerr << "give argument value for number of SCC parallel workers please after "
+							<< args[i - 1] << endl;
+					usage();
+					exit(1);
+				}
+				char * end;
+				long n = strtol(args[i], &end, 10);
+				if (*end != '\0' || n < 1) {
+					cerr << "Invalid number of SCC parallel workers " << args[i] << endl;
+					usage();
+					exit(1);
+				}
+				scc_parallel = n;
+			} else if (!strcmp(args[i], "--fs-parity")) {
+				fs_parity = true;
+			} else if (!strcmp(args[i], "--fs-tgba-pos")) {
+				if (++i >= argc) {
+					cerr << "give argument value for automaton position please after "
+							<< args[i - 1] << endl;
+					usage();
+					exit(1);
+				}
+				if (!strcmp(args[i], "top")) {
+					fs_tgba_top = true;
+				} else if (!strcmp(args[i], "bottom")) {
+					fs_tgba_top = false;
+				} else {
+					cerr << "Unknown automaton position " << args[i] << endl;
+					usage();
+					exit(1);
+				}
+			} else if (!strcmp(args[i], "--sog-cache")) {
+				if (++i >= argc) {
+					cerr << "give argument value for SOG cache folder please after "
+							<< args[i - 1] << endl;
+					usage();
+					exit(1);
+				}
+				sog_cache_dir = args[i];
 			} else if (!strncmp(args[i], "-LTL", 4)) {
 				if (++i > argc) {
 					cerr
@@ -238,6 +382,12 @@ int main(int argc, const char *argv[]) {
 				sogtype = FS_EL;
 			} else if (!strcmp(args[i], "-SFSOWCTY")) {
 				sogtype = FS_OWCTY;
+			} else if (!strcmp(args[i], "-SFSOWCTY-BWD")) {
+				sogtype = FS_OWCTY_BWD;
+			} else if (!strcmp(args[i], "-SFSEL-BWD")) {
+				sogtype = FS_EL_BWD;
+			} else if (!strcmp(args[i], "-SFSLOCKSTEP")) {
+				sogtype = FS_LOCKSTEP;
 			} else if (!strcmp(args[i], "-SFSOWCTY-TGTA")) {
 				sogtype = FS_OWCTY_TGTA;
 			} else if (!strcmp(args[i], "-SSOG-TGTA")) {
@@ -260,8 +410,30 @@ int main(int argc, const char *argv[]) {
 		}
 		args = argsleft;
 
+		// the SOG cache is keyed by the contents of the model file, formats that read other files are refused
+		sog_cache * sogcache = nullptr;
+		if (! sog_cache_dir.empty()) {
+			std::string model_file;
+			std::string model_format;
+			for (size_t i = 0; i + 1 < args.size(); i++) {
+				if (!strcmp(args[i], "-i")) {
+					model_file = args[i + 1];
+				} else if (!strcmp(args[i], "-t")) {
+					model_format = args[i + 1];
+				}
+			}
+			if (model_format == "PROD" || model_format == "CAMI"
+					|| model_format == "ETF" || model_format == "DVE") {
+				sogcache = new sog_cache(sog_cache_dir, model_file);
+			} else {
+				std::cerr << "SOG cache is only available for models held in a single file (PROD, CAMI, ETF, DVE), ignored for format "
+						<< model_format << "." << std::endl;
+			}
+		}
+
 		ITSModel *model;
-		if (sogtype == FS_OWCTY || sogtype == FS_EL) {
+		if (sogtype == FS_OWCTY || sogtype == FS_EL || sogtype == FS_OWCTY_BWD
+				|| sogtype == FS_EL_BWD || sogtype == FS_LOCKSTEP) {
 			model = new fsltlModel();
 		} else if (sogtype == FS_OWCTY_TGTA || sogtype == SLAP_TGTA
 				|| sogtype == SLAP_DTGTA) {
@@ -276,17 +448,6 @@ int main(int argc, const char *argv[]) {
 			return 1;
 		}
 
-		if (sogtype == FS_OWCTY_TGTA || sogtype == SLAP_TGTA
-				|| sogtype == SLAP_DTGTA) {
-			if (((fsltlTestingModel*) model)->getTestingModel() == NULL) {
-				std::cerr
-						<< "Please specify input problem type with option -t. Supported type is :  {ETF} \n";
-				cerr << "The TGTA approaches can only be used with ETF models"
-						<< endl;
-				exit(2);
-				return 1;
-			}
-		}
 		// we now should have the model defined.
 		string modelName = model->getInstance()->getType()->getName();
 
@@ -343,6 +504,19 @@ int main(int argc, const char *argv[]) {
 					if (isPlaceSyntax) {
 						checker.setPlaceSyntax(true);
 					}
+					checker.setConeOfInfluence(coi);
+					checker.setFsDecision(fs_decision);
+					checker.setFsSCC(fs_scc);
+					checker.setFsEncoding(fs_encoding);
+					checker.setFsTgbaOnTop(fs_tgba_top);
+					checker.setFsParity(fs_parity);
+					checker.setFsStutter(fs_stutter);
+					checker.setFsStats(fs_stats);
+					checker.setFsFixedOrder(fs_fixed_order);
+					checker.setFairness(weak_fair, strong_fair);
+					checker.setSwarm(swarm);
+					checker.setSccParallel(scc_parallel);
+					checker.setSogCache(sogcache);
 					bool res = checker.model_check(sogtype);
 					std::cout << "Formula " << idform << " is ";
 					if (res) {
@@ -379,6 +553,18 @@ int main(int argc, const char *argv[]) {
 					fm_symb_merge_opt, post_branching, fair_loop_approx,
 					"STATS", print_rg, scc_optim, scc_optim_full,
 					print_formula_tgba, stutter_dead);
+			checker.setConeOfInfluence(coi);
+			checker.setFsDecision(fs_decision);
+			checker.setFsSCC(fs_scc);
+			checker.setFsEncoding(fs_encoding);
+			checker.setFsTgbaOnTop(fs_tgba_top);
+			checker.setFsStutter(fs_stutter);
+			checker.setFsStats(fs_stats);
+			checker.setFsFixedOrder(fs_fixed_order);
+			checker.setFairness(weak_fair, strong_fair);
+			checker.setSwarm(swarm);
+			checker.setSccParallel(scc_parallel);
+			checker.setSogCache(sogcache);
 
 			bool res = checker.model_check(sogtype);
 			std::cout << "Formula " << idform << " is ";
@@ -393,6 +579,7 @@ int main(int argc, const char *argv[]) {
 
 
 
+		delete sogcache;
 		delete model;
 		// external block for full garbage
 	}
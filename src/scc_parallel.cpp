@@ -0,0 +1,113 @@
+#include "scc_parallel.hh"
+
+#include <cassert>
+
+namespace sogits {
+
+  const spot::state * replay_path (const spot::const_twa_ptr & prod, const succ_path_t & path) {
+    const spot::state * s = prod->get_init_state();
+    for (unsigned pos : path) {
+      spot::twa_succ_iterator * it = prod->succ_iter(s);
+      const spot::state * next = nullptr;
+      unsigned i = 0;
+      for (it->first(); !it->done(); it->next(), ++i) {
+	if (i == pos) {
+	  next = it->dst();
+	  break;
+	}
+      }
+      prod->release_iter(it);
+      s->destroy();
+      if (! next)
+	return nullptr;
+      s = next;
+    }
+    return s;
+  }
+
+  scc_task_twa::scc_task_twa (const spot::const_twa_ptr & inner, int scc, const spot::state * entry,
+			      const succ_path_t & entryPath, const scc_of_t & sccOf,
+			      const is_useful_t & isUseful, const key_of_t & keyOf, FILE * out)
+    : spot::twa(inner->get_dict()), inner_(inner), scc_(scc), entry_(entry), entryPath_(entryPath),
+      sccOf_(sccOf), isUseful_(isUseful), keyOf_(keyOf), out_(out) {
+    copy_ap_of(inner);
+    copy_acceptance_of(inner);
+    pred_.emplace(entry_, std::make_pair((const spot::state*) nullptr, 0U));
+  }
+
+  scc_task_twa::~scc_task_twa () {
+    for (auto & p : pred_) {
+      p.first->destroy();
+    }
+    for (const spot::state * s : exits_) {
+      s->destroy();
+    }
+  }
+
+  succ_path_t scc_task_twa::path_of (const spot::state * s) const {
+    succ_path_t rev;
+    auto it = pred_.find(s);
+    assert(it != pred_.end());
+    while (it->second.first != nullptr) {
+      rev.push_back(it->second.second);
+      it = pred_.find(it->second.first);
+      assert(it != pred_.end());
+    }
+    succ_path_t res = entryPath_;
+    res.insert(res.end(), rev.rbegin(), rev.rend());
+    return res;
+  }
+
+  spot::state* scc_task_twa::get_init_state () const {
+    return entry_->clone();
+  }
+
+  spot::twa_succ_iterator* scc_task_twa::succ_iter (const spot::state* local_state) const {
+    // the emptiness check only asks for states it got from this automaton
+    auto srcit = pred_.find(local_state);
+    assert(srcit != pred_.end());
+    const spot::state * src = srcit->first;
+
+    std::vector<stored_succ_iterator::succ_t> succs;
+    spot::twa_succ_iterator * it = inner_->succ_iter(local_state);
+    unsigned pos = 0;
+    for (it->first(); !it->done(); it->next(), ++pos) {
+      const spot::state * dst = it->dst();
+      int scc = sccOf_(dst);
+      if (scc == scc_ || scc < 0) {
+	if (pred_.find(dst) == pred_.end()) {
+	  pred_.emplace(dst->clone(), std::make_pair(src, pos));
+	}
+	succs.push_back({ dst, it->cond(), it->acc() });
+	continue;
+      }
+      // leaving the SCC : a new task, unless it cannot lead to acceptance
+      if (isUseful_(scc) && exits_.insert(dst).second) {
+	succ_path_t path = path_of(src);
+	path.push_back(pos);
+	fprintf(out_, "%d %s", scc, keyOf_(dst).c_str());
+	for (unsigned p : path) {
+	  fprintf(out_, " %u", p);
+	}
+	fprintf(out_, "\n");
+	fflush(out_);
+      } else {
+	dst->destroy();
+      }
+    }
+    inner_->release_iter(it);
+    return new stored_succ_iterator(std::move(succs));
+  }
+
+  std::string scc_task_twa::format_state (const spot::state* state) const {
+    return inner_->format_state(state);
+  }
+
+  spot::state* scc_task_twa::project_state (const spot::state* s,
+					    const spot::const_twa_ptr& t) const {
+    if (t.get() == this)
+      return s->clone();
+    return inner_->project_state(s, t);
+  }
+
+}
@@ -0,0 +1,72 @@
+#ifndef SOG_SCC_PARALLEL_HH
+#define SOG_SCC_PARALLEL_HH
+
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <spot/twa/twa.hh>
+#include "swarm.hh"
+
+namespace sogits {
+
+  /// A path in a product, as the positions of the successors taken from its initial state.
+  /// Product successors are enumerated in a deterministic order, so that any process
+  /// holding the same product can recompute the state a path leads to.
+  typedef std::vector<unsigned> succ_path_t;
+
+  /// recompute the state reached through path in prod (the caller owns it), nullptr if the path is invalid.
+  const spot::state * replay_path (const spot::const_twa_ptr & prod, const succ_path_t & path);
+
+  /// \brief The part of a product that stays in one SCC of the automaton, from one entry state.
+  /// Arcs that leave the SCC are cut. Each time one of them reaches a state not yet reported,
+  /// with a useful automaton SCC (one that can still lead to acceptance), the path to that state
+  /// is written to out as a line "<scc> <key> <positions...>", to become a new task.
+  /// The key identifies the state in any process, so that duplicate tasks are dropped without replaying paths.
+  class scc_task_twa : public spot::twa
+  {
+  public :
+    /// the automaton SCC of a product state, -1 if it has none (initial and divergent states).
+    typedef std::function<int (const spot::state *)> scc_of_t;
+    typedef std::function<bool (int)> is_useful_t;
+    /// a key of a product state, without blanks, equal for equal states in any process forked from the same parent.
+    typedef std::function<std::string (const spot::state *)> key_of_t;
+
+  private :
+    spot::const_twa_ptr inner_;
+    int scc_;
+    const spot::state * entry_;
+    succ_path_t entryPath_;
+    scc_of_t sccOf_;
+    is_useful_t isUseful_;
+    key_of_t keyOf_;
+    FILE * out_;
+    // the states of the task, with their predecessor and successor position, keys are owned
+    mutable spot::state_map<std::pair<const spot::state*, unsigned> > pred_;
+    // the exits already reported, owned
+    mutable spot::state_set exits_;
+
+    succ_path_t path_of (const spot::state * s) const;
+
+  public :
+    /// entry is owned by the task from now on
+    scc_task_twa (const spot::const_twa_ptr & inner, int scc, const spot::state * entry,
+		  const succ_path_t & entryPath, const scc_of_t & sccOf,
+		  const is_useful_t & isUseful, const key_of_t & keyOf, FILE * out);
+    virtual ~scc_task_twa ();
+
+    virtual spot::state* get_init_state () const override;
+
+    virtual spot::twa_succ_iterator*
+    succ_iter (const spot::state* local_state) const override;
+
+    virtual std::string format_state (const spot::state* state) const override;
+
+    virtual spot::state* project_state (const spot::state* s,
+					const spot::const_twa_ptr& t) const override;
+  };
+
+}
+
+#endif
@@ -40,17 +40,6 @@ namespace slap
 
   ////////////////////////////////////////////////////////////
   // state_product
-  slap_state::slap_state(const slap_state& o)
-    : state(),
-      left_(o.left()->clone()),
-      right_(o.right())
-  {
-  }
-
-  slap_state::~slap_state()
-  {
-    left_->destroy();
-  }
 
   int
   slap_state::compare(const state* other) const
@@ -60,26 +49,83 @@ namespace slap
 
     const slap_state* o = dynamic_cast<const slap_state*>(other);
     assert(o);
-    int res = left_->compare(o->left());
-    if (res != 0)
-      return res;
-    if (right_ == o->right())
+    // ids are only comparable in one store
+    assert(o->store_ == store_);
+    // interned : equal pairs have the same id
+    if (id_ == o->id())
       return 0;
-    else
-      return right_ < o->right() ? 1 : -1;
+    return id_ < o->id() ? -1 : 1;
   }
 
   size_t
   slap_state::hash() const
   {
-    // We assume that size_t is 32-bit wide.
-    return wang32_hash(left_->hash()) ^ right_.hash();
+    return wang32_hash(id_);
   }
 
   slap_state*
   slap_state::clone() const
   {
-    return new slap_state(*this);
+    ++refs_;
+    return const_cast<slap_state*>(this);
+  }
+
+  void
+  slap_state::destroy() const
+  {
+    assert(refs_ > 0);
+    if (--refs_ == 0)
+      store_->release(const_cast<slap_state*>(this));
+  }
+
+  ////////////////////////////////////////////////////////////
+  // slap_state_store
+
+  slap_state_store::~slap_state_store()
+  {
+    // a state still referenced here would dangle in its holder
+    assert(index_.empty());
+  }
+
+  slap_state*
+  slap_state_store::intern(const spot::state* left, const its::State & right)
+  {
+    auto it = index_.find({ left, right });
+    if (it != index_.end())
+      {
+	left->destroy();
+	slap_state* s = entries_[it->second].state;
+	++s->refs_;
+	return s;
+      }
+    unsigned id;
+    if (freeIds_.empty())
+      {
+	id = entries_.size();
+	entries_.push_back({ nullptr, nullptr });
+      }
+    else
+      {
+	id = freeIds_.back();
+	freeIds_.pop_back();
+      }
+    auto ins = index_.emplace(key_t { left, right }, id);
+    slap_state* s = new slap_state(id, this);
+    entries_[id] = { &ins.first->first, s };
+    return s;
+  }
+
+  void
+  slap_state_store::release(slap_state* s)
+  {
+    unsigned id = s->id();
+    assert(s->store_ == this && entries_[id].state == s);
+    const spot::state* left = entries_[id].pair->left;
+    index_.erase(index_.find(*entries_[id].pair));
+    left->destroy();
+    entries_[id] = { nullptr, nullptr };
+    freeIds_.push_back(id);
+    delete s;
   }
 
   ////////////////////////////////////////////////////////////
@@ -94,13 +140,15 @@ namespace slap
 					 twa_succ_iterator* left,
 					 const sogIts & model,
 					 const its::State& right,
-					 sogits::FSTYPE fsType)
+					 sogits::FSTYPE fsType,
+					 slap_state_store & store)
     : aut_(aut),
       aut_state_(aut_state),
       left_(left),
       model_(model),
       right_(right),
-      fsType_(fsType)
+      fsType_(fsType),
+      store_(store)
   {
 
     /** Test whether there is a self loop labeled with ALL acceptance conditions */
@@ -231,7 +279,7 @@ namespace slap
   const slap_state*
   slap_succ_iterator::dst() const
   {
-    return new slap_state(left_->dst(), dest_);
+    return store_.intern(left_->dst(), dest_);
   }
 
   bdd
@@ -280,8 +328,8 @@ namespace slap
 	  F |= it->cond();
       }
 
-    return new slap_state(init_tgba,
-			  model_.leastPreTestFixpoint (model_.getInitialState(), F));
+    return store_.intern(init_tgba,
+			 model_.leastPreTestFixpoint (model_.getInitialState(), F));
   }
 
 
@@ -336,6 +384,8 @@ namespace slap
       trace << "could use FSLTL algo !!" << std::endl;
       its::fsltlModel::trans_t nextAccs;
       its::Transition all = its::State::null;
+      // the AP conditions of the self loops
+      its::Transition loopcond = its::Transition::null;
 
       typedef std::map<std::string,its::Transition> accToTrans_t;
       typedef accToTrans_t::iterator accToTrans_it;
@@ -349,6 +399,7 @@ namespace slap
 	  its::Transition toadd = model_.getNextRel () & apcond;
 
 	  all = all + toadd;
+	  loopcond = loopcond + apcond;
 
 	  labels_t accs = its::TgbaType::getAcceptanceSet (li->acc());
 	  for (labels_it acc = accs.begin() ; acc != accs.end() ; ++acc) {
@@ -369,7 +420,31 @@ namespace slap
       }
 
 
-      its::State scc = its::fsltlModel::findSCC_owcty (all, nextAccs, s->right());
+      // fairness of model transitions : weak adds acceptance relations, strong refines the result
+      its::fsltlModel::strong_fairs_t strong;
+      if (model_.hasFairness()) {
+	its::State reach = fixpoint (all + its::Transition::id, true) (s->right());
+	const labels_t & weak = model_.getWeakFairness();
+	for (labels_it it = weak.begin() ; it != weak.end() ; ++it) {
+	  its::Transition t = model_.getNamedTransition(*it);
+	  its::State enabled = its::fsltlModel::getEnabled(t, reach);
+	  nextAccs.push_back(its::fsltlModel::getWeakFairRel(all, t & loopcond, enabled, reach));
+	}
+	const labels_t & strongNames = model_.getStrongFairness();
+	for (labels_it it = strongNames.begin() ; it != strongNames.end() ; ++it) {
+	  its::Transition t = model_.getNamedTransition(*it);
+	  its::fsltlModel::strong_fair_t sf;
+	  sf.enabled = its::fsltlModel::getEnabled(t, reach);
+	  sf.fired = t & loopcond;
+	  strong.push_back(sf);
+	}
+      }
+
+      // only emptiness matters here
+      its::State scc = its::fsltlModel::findSCC_fsltl (all, nextAccs, s->right(), true, true);
+      if (scc != its::State::null && ! strong.empty()) {
+	scc = its::fsltlModel::findSCC_lockstep (all, nextAccs, scc, strong);
+      }
 
       if (scc == its::State::null) {
 	if (fsType_ == sogits::FST
@@ -377,7 +452,7 @@ namespace slap
 	  return new tgba_no_succ_iterator();
 	} else if ( fsType_ == sogits::FSA ) {
 	  // default back to basic behavior
-	  return new slap_succ_iterator(left_.get(), s->left(), li, model_, s->right(),fsType_);
+	  return new slap_succ_iterator(left_.get(), s->left(), li, model_, s->right(),fsType_, store_);
 	}
       } else {
 	return new slap_div_succ_iterator(get_dict(), s, bddtrue, left_->acc().all_sets());
@@ -385,7 +460,7 @@ namespace slap
     }
 
     // std::cerr << "Building succ_iter from state : " << left_->format_state (s->left()) << std::endl;
-    return new slap_succ_iterator(left_.get(), s->left(), li, model_, s->right(),fsType_);
+    return new slap_succ_iterator(left_.get(), s->left(), li, model_, s->right(),fsType_, store_);
   }
 
   bool slap_tgba::isSelfLoop(const twa_succ_iterator * it,
@@ -22,7 +22,10 @@
 #ifndef SPOT_TGBA_SLAPPRODUCT_HH
 # define SPOT_TGBA_SLAPPRODUCT_HH
 
+#include <unordered_map>
+#include <vector>
 #include <spot/twa/twa.hh>
+#include <spot/misc/hashfunc.hh>
 #include "sogIts.hh"
 #include "sogtgbautils.hh"
 
@@ -31,51 +34,120 @@
 namespace slap
 {
 
+  class slap_state_store;
+
   /// \brief A state for spot::tgba_product.
   /// \ingroup tgba_on_the_fly_algorithms
   ///
   /// This state is in fact a pair of state: the state from the left
   /// automaton and that of the right.
+  /// Product states are handles interned by a slap_state_store, which holds the pair :
+  /// clone and destroy only count references, compare and hash only look at the id.
   class slap_state final: public spot::state
   {
   public:
     /// \brief Constructor
-    /// \param left The state from the left automaton.
-    /// \param right The state from the right automaton.
-    /// These states are acquired by spot::state_product, and will
-    /// be deleted on destruction.
-    slap_state(const spot::state* left, its::State right)
-      :	left_(left),
-	right_(right)
+    /// \param id The dense number of the pair in its store.
+    /// \param store The store holding the pair, notified when the last reference is destroyed.
+    slap_state(unsigned id, slap_state_store* store)
+      :	id_(id),
+	store_(store),
+	refs_(1)
     {
     }
 
-    /// Copy constructor
-    slap_state(const slap_state& o);
-
-    virtual ~slap_state();
+    /// State from the left automaton.
+    const state* left() const;
 
-    const state*
-    left() const
-    {
-      return left_;
-    }
+    /// State from the right automaton.
+    its::State right() const;
 
-    its::State
-    right() const
+    unsigned
+    id() const
     {
-      return right_;
+      return id_;
     }
 
     virtual int compare(const state* other) const override;
     virtual size_t hash() const override;
     virtual slap_state* clone() const override;
+    virtual void destroy() const override;
 
   private:
-    const spot::state* left_;	///< State from the left automaton.
-    its::State right_;		///< State from the right automaton.
+    slap_state(const slap_state& o) = delete;
+    friend class slap_state_store;
+
+    unsigned id_;		///< Number in the store.
+    slap_state_store* store_;	///< The store of the state.
+    mutable unsigned refs_;	///< Number of live references.
   };
 
+  /// \brief Interns the states of a product : each distinct (automaton state, aggregate)
+  /// pair is stored once while it is referenced, and numbered densely.
+  /// The number of a released pair is reused, so ids stay below the peak number of live states.
+  /// All states must have been destroyed before the store.
+  class slap_state_store
+  {
+  public:
+    slap_state_store() {}
+    ~slap_state_store();
+
+    /// The pair of a live state.
+    const spot::state* left(unsigned id) const { return entries_[id].pair->left; }
+    const its::State & right(unsigned id) const { return entries_[id].pair->right; }
+
+    /// The state of the pair (left, right), with a new reference ; left is acquired by the store.
+    slap_state* intern(const spot::state* left, const its::State & right);
+
+    /// Drop a state whose last reference was destroyed.
+    void release(slap_state* s);
+
+    /// The number of live states.
+    size_t size() const { return index_.size(); }
+
+  private:
+    struct key_t {
+      const spot::state* left;
+      its::State right;
+    };
+    struct key_hash {
+      size_t operator() (const key_t & k) const {
+	return spot::wang32_hash(k.left->hash()) ^ k.right.hash();
+      }
+    };
+    struct key_equal {
+      bool operator() (const key_t & a, const key_t & b) const {
+	return a.left->compare(b.left) == 0 && a.right == b.right;
+      }
+    };
+    // the pairs, with the id of their state
+    std::unordered_map<key_t, unsigned, key_hash, key_equal> index_;
+    struct entry_t {
+      // the key of the pair in index_ (nodes of an unordered_map are stable)
+      const key_t* pair;
+      slap_state* state;
+    };
+    // by id, null state for free ids
+    std::vector<entry_t> entries_;
+    std::vector<unsigned> freeIds_;
+
+    // Disallow copy.
+    slap_state_store(const slap_state_store&) = delete;
+    slap_state_store& operator=(const slap_state_store&) = delete;
+  };
+
+  inline const spot::state*
+  slap_state::left() const
+  {
+    return store_->left(id_);
+  }
+
+  inline its::State
+  slap_state::right() const
+  {
+    return store_->right(id_);
+  }
+
 
   /// \brief Iterate over the successors of a product computed on the fly.
   class slap_succ_iterator: public spot::twa_succ_iterator
@@ -87,7 +159,8 @@ namespace slap
      * right : the source aggregate */
     slap_succ_iterator(const spot::twa* aut, const spot::state* aut_state,
 		       spot::twa_succ_iterator* left, const sogIts& model,
-		       const its::State& right, sogits::FSTYPE fsType_);
+		       const its::State& right, sogits::FSTYPE fsType_,
+		       slap_state_store & store);
 
     virtual ~slap_succ_iterator();
 
@@ -119,6 +192,7 @@ namespace slap
     its::State right_; ///< The source state.
     its::State dest_; ///< The current successor aggregate (could be empty).
     sogits::FSTYPE fsType_;
+    slap_state_store & store_; ///< The product states.
   };
 
 
@@ -199,6 +273,8 @@ namespace slap
     spot::const_twa_ptr left_;
     const sogIts & model_;
     sogits::FSTYPE fsType_;
+    // the product states currently referenced
+    mutable slap_state_store store_;
 
     // test for fully symbolic exploration
     bool isFullAcceptingState (spot::twa_succ_iterator* it, const spot::state * source) const ;
@@ -39,48 +39,16 @@ namespace slap
 
   tgta_slap_succ_iterator::tgta_slap_succ_iterator(const spot::twa* aut,
       const spot::state * aut_state, spot::twa_succ_iterator* left,
-      const sogIts & model, const its::State& right, sogits::FSTYPE fsType_) :
-    slap_succ_iterator(aut, aut_state, left, model, right, fsType_)
+      const sogIts & model, const its::State& right, sogits::FSTYPE fsType_,
+      const slap_tgta * prod, slap_state_store & store) :
+    slap_succ_iterator(aut, aut_state, left, model, right, fsType_, store), prod_(prod)
   {
-    model_labled_by_changesets_ = (its::EtfTestingType*) model.getType();
-  }
-
-  its::Transition
-  tgta_slap_succ_iterator::compute_weaker_selfloop_trans()
-  {
-    // The acceptance condition labeling the arc of the tgba
-    spot::acc_cond::mark_t ac = left_->acc();
-    // The state reached in the tgba through this arc
-    const state * q2 = left_->dst();
-
-    // Iterate over q2's successors, and add to selfLoopsTrans the its::Transitions which are on arcs "weaker" (wrt ac)
-    its::Transition selfLoopsTrans = its::Transition::null;
-
-    for (auto it: aut_->succ(q2))
-      {
-        const state * dest = it->dst();
-
-        // Test self loop
-        if (dest->compare(q2) == 0)
-          {
-            // Test ac=>ac' (subsume the arc)
-	    spot::acc_cond::mark_t acprime = it->acc();
-            if ((ac & acprime) == acprime)
-              selfLoopsTrans = selfLoopsTrans
-                  + model_labled_by_changesets_->getLocalsByChangeSet(it->cond());
-          }
-        dest->destroy();
-      }
-    q2->destroy();
-
-    return selfLoopsTrans;
   }
 
   void
   tgta_slap_succ_iterator::step_()
   {
-    const state * tgta_artificial_init_state = aut_->get_init_state();
-    if (aut_state_->compare(tgta_artificial_init_state) == 0)
+    if (prod_->isArtificialInit(aut_state_))
       {
 
         //case 1: aut_state_ is the artificial initial state of the TGTA
@@ -94,32 +62,15 @@ namespace slap
                   << aut_->format_state(left_->dst()) << std::endl;
             trace << "right_==model_.getInitialState()" << (right_
                   == model_.getInitialState()) << std::endl;
-            trace << "apcond(model_.getInitialState())" << apcond(
-                  model_.getInitialState()) << std::endl;
-            trace << "apcond(right_)" << apcond(right_) << std::endl;
-
-            // Iterate over init states successors, and add to F the atomic props which are on arcs without acceptance conds
-            const state * init_tgta = left_->dst();
-            its::Transition selfLoopsTrans = its::Transition::id;
-	    for (auto it: aut_->succ(init_tgta))
+
+            // Saturate under the init state successor self loops without acceptance conds
+            its::Transition sat = its::Transition::id;
+            if (aut_->num_sets() > 0)
               {
-                const state * dest = it->dst();
-                // Test self loop
-                if (dest->compare(init_tgta) == 0)
-                  {
-                    // Test ac=0 (empty acceptance cond arcs)
-                    if (!it->acc() && aut_->num_sets() > 0)
-		      selfLoopsTrans = selfLoopsTrans
-			+ model_labled_by_changesets_->getLocalsByChangeSet(it->cond());
-                  }
-                dest->destroy();
+                const state * init_tgta = left_->dst();
+                sat = prod_->getSelfLoopSaturation(init_tgta, spot::acc_cond::mark_t());
+                init_tgta->destroy();
               }
-            init_tgta->destroy();
-
-            its::Transition sat = fixpoint(selfLoopsTrans, true);
-            trace
-                  << "tgta_slap_succ_iterator:Saturate (pre) least fixpoint under selfLoop changesets : "
-                  << selfLoopsTrans << std::endl;
             dest_ = sat(right_);
           }
 
@@ -147,90 +98,128 @@ namespace slap
 
         // progress to "entry" states of succ in ITS model
         bdd changeset = left_->cond();
-        //trace << "case 2:" << aut_->format_state(aut_state_)
-        //  << "----> left_->current_condition()" << bdd_format_formula(
-        //aut_->get_dict(), left_->current_condition()) << "----> "
-        //<< aut_->format_state(left_->current_state()) << std::endl;
         its::Transition succByChangeset =
-            model_labled_by_changesets_->getLocalsByChangeSet(changeset);
-        //trace << "right_ : " << right_ << std::endl;
+            prod_->getLocalsByChangeSet(changeset);
         dest_ = succByChangeset(right_);
-        //trace << "succByChangeset(right_) : " << dest_ << std::endl;
         if (dest_.empty())
           return;
 
-        // grab the current subsumed arc conditions
-        bdd F = compute_weaker_selfloop_ap();
-
-        trace << "grab the current subsumed self loops arc with changeset="
-              << bdd_format_formula(aut_->get_dict(), F) << std::endl;
+        // costly saturate the aggregate under the subsumed self loops of the destination
+        const state * q2 = left_->dst();
+        dest_ = prod_->getSelfLoopSaturation(q2, left_->acc())(dest_);
+        q2->destroy();
+      }
 
-        if (F == bddfalse)
-          return;
+  }
 
-        its::Transition selfLoopsTrans =
-            model_labled_by_changesets_->getLocalsByChangeSet(F);
+  slap_tgta::slap_tgta(const spot::const_twa_ptr& left, const sogIts & right,
+      sogits::FSTYPE fsType) :
+    slap_tgba(left, right, fsType)
+  {
 
-        if (selfLoopsTrans == its::Transition::null)
-          {
-            trace
-                  << "computing selfLoopsTrans because it is not in TestingModel Map, where changeset= "
-                  << bdd_format_formula(aut_->get_dict(), F) << std::endl;
-
-            trace
-                  << "computing selfLoopsTrans: grab the current subsumed self loop transitions"
-                  << std::endl;
-            selfLoopsTrans = compute_weaker_selfloop_trans();
-          }
+    init_ = left->get_init_state();
+    // only ETF models have explicit changeset relations, to be computed up front
+    its::EtfTestingType* etf =
+        dynamic_cast<its::EtfTestingType*> ((its::Type*) right.getType());
+    model_labled_by_changesets_ = etf;
+    if (!etf)
+      return;
 
-        if (selfLoopsTrans != its::Transition::null)
+    // Collect the TGTA arc conditions by exploring it
+    std::set<bdd, bdd_less_than> all_changesets;
+    state_unicity_table seen;
+    std::vector<const state*> todo;
+    todo.push_back(seen(left->get_init_state()));
+    while (!todo.empty())
+      {
+        const state* src = todo.back();
+        todo.pop_back();
+        for (auto it: left->succ(src))
           {
-            // costly saturate the aggregate
-            its::Transition sat = fixpoint(
-                selfLoopsTrans + its::Transition::id, true);
-            dest_ = sat(dest_);
+            // in TGTA, change_set = (source_state_condition) XOR (destination_state_condition)
+            all_changesets.insert(it->cond());
+            const state* dst = seen.is_new(it->dst());
+            if (dst)
+              todo.push_back(dst);
           }
       }
 
+    //Statistic sB(initState_, "*** Before compute_transitions_by_changesets");
+    //sB.print_line(trace);
+    etf->compute_transitions_by_changesets(all_changesets);
   }
+  ;
 
-  slap_tgta::slap_tgta(const spot::const_twa_ptr& left, const sogIts & right,
-      sogits::FSTYPE fsType) :
-    slap_tgba(left, right, fsType)
+  slap_tgta::~slap_tgta()
   {
+    for (auto & q : selfLoopSat_)
+      q.first->destroy();
+    init_->destroy();
+  }
 
-    its::EtfTestingType* model_labled_by_changesets_ =
-        (its::EtfTestingType*) right.getType();
+  bool
+  slap_tgta::isArtificialInit(const state* s) const
+  {
+    return s->compare(init_) == 0;
+  }
 
-    // Grab the TGTA labels
-    its::TgbaType * tgta_ = new its::TgbaType(left);
-    labels_t tgbalabs = tgta_->getTransLabels();
+  its::Transition
+  slap_tgta::getLocalsByChangeSet(bdd changeset) const
+  {
+    if (model_labled_by_changesets_)
+      return model_labled_by_changesets_->getLocalsByChangeSet(changeset);
+    return model_.getNextByChangeSet(changeset);
+  }
 
-    std::set<bdd, bdd_less_than> all_changesets;
+  its::Transition
+  slap_tgta::getLocalsByChangeSets(const std::vector<bdd> & changesets) const
+  {
+    if (model_labled_by_changesets_)
+      return model_labled_by_changesets_->getLocalsByChangeSets(changesets);
+    its::Transition res = its::Transition::null;
+    for (const bdd & changeset : changesets)
+      res = res + model_.getNextByChangeSet(changeset);
+    return res;
+  }
 
-    for (labels_it it = tgbalabs.begin(); it != tgbalabs.end(); ++it)
+  its::Transition
+  slap_tgta::getSelfLoopSaturation(const state* q, acc_cond::mark_t ac) const
+  {
+    auto qit = selfLoopSat_.find(q);
+    if (qit == selfLoopSat_.end())
+      qit = selfLoopSat_.emplace(q->clone(), std::map<acc_cond::mark_t, its::Transition>()).first;
+    auto it = qit->second.find(ac);
+    if (it != qit->second.end())
+      return it->second;
+
+    // collect the changesets of the self loops of q "weaker" (wrt ac) : ac=>ac' (subsume the arc)
+    std::vector<bdd> selfLoops;
+    for (auto succ: left_->succ(q))
       {
-        its::TgbaType::tgba_arc_label_t arcLab =
-            tgta_->getTransLabelDescription(*it);
-
-        // in TGTA, change_set = (source_state_condition) XOR (destination_state_condition)
-        bdd change_set = arcLab.first;
-        all_changesets.insert(change_set);
+        const state * dest = succ->dst();
+        acc_cond::mark_t acprime = succ->acc();
+        if (dest->compare(q) == 0 && (ac & acprime) == acprime)
+          selfLoops.push_back(succ->cond());
+        dest->destroy();
       }
 
-    //Statistic sB(initState_, "*** Before compute_transitions_by_changesets");
-    //sB.print_line(trace);
-    model_labled_by_changesets_->compute_transitions_by_changesets(
-        all_changesets);
-
-    delete tgta_;
+    its::Transition sat = its::Transition::id;
+    if (! selfLoops.empty())
+      {
+        its::Transition selfLoopsTrans = getLocalsByChangeSets(selfLoops);
+        if (selfLoopsTrans != its::Transition::null)
+          sat = fixpoint(selfLoopsTrans + its::Transition::id, true);
+      }
+    trace << "slap_tgta: caching self loop saturation of " << left_->format_state(q)
+          << " for " << ac << " : " << sat << std::endl;
+    qit->second.emplace(ac, sat);
+    return sat;
   }
-  ;
 
   state*
   slap_tgta::get_init_state() const
   {
-    return new slap_state(left_->get_init_state(), model_.getInitialState());
+    return store_.intern(left_->get_init_state(), model_.getInitialState());
   }
 
   spot::twa_succ_iterator*
@@ -245,7 +234,7 @@ namespace slap
 
     // trace << "Building succ_iter from state : " << left_->format_state (s->left()) << std::endl;
     return new tgta_slap_succ_iterator(left_.get(), s->left(), li, model_,
-				       s->right(), fsType_);
+				       s->right(), fsType_, this, store_);
   }
 
 }
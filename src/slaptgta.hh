@@ -21,6 +21,7 @@
 #ifndef SPOT_TGTA_SLAPPRODUCT_HH
 # define SPOT_TGTA_SLAPPRODUCT_HH
 
+#include <map>
 #include <spot/ta/tgta.hh>
 #include "slap.hh"
 #include "etf/ETFTestingType.hh"
@@ -29,6 +30,8 @@
 namespace slap
 {
 
+  class slap_tgta;
+
   /// \brief Iterate over the successors of a product computed on the fly.
   class tgta_slap_succ_iterator final : public slap_succ_iterator
   {
@@ -36,10 +39,12 @@ namespace slap
     /** aut : the automaton, passed to allow creation of iterators
      * left : the current succ iter on the autoamaton
      * model : the ITS model
-     * right : the source aggregate */
+     * right : the source aggregate
+     * prod : the product, holding the relations cached per automaton state */
     tgta_slap_succ_iterator(const spot::twa * aut,
         const spot::state * aut_state, spot::twa_succ_iterator* left,
-        const sogIts & model, const its::State& right, sogits::FSTYPE fsType_);
+        const sogIts & model, const its::State& right, sogits::FSTYPE fsType_,
+        const slap_tgta * prod, slap_state_store & store);
 
     //virtual ~tgta_slap_succ_iterator();
 
@@ -59,14 +64,12 @@ namespace slap
     virtual void
     step_() override;
     //void next_non_false_();
-    its::Transition
-    compute_weaker_selfloop_trans();
     //@}
 
     // to allow pretty printing of arc annotations
     friend class slap_tgta;
   protected:
-    its::EtfTestingType* model_labled_by_changesets_;
+    const slap_tgta * prod_;
   };
 
   /// \brief A lazy product.  (States are computed on the fly.)
@@ -77,12 +80,37 @@ namespace slap
     slap_tgta(const spot::const_twa_ptr& left, const sogIts & right,
         sogits::FSTYPE fsType);
 
+    virtual ~slap_tgta();
+
     virtual spot::state*
     get_init_state() const;
 
     virtual spot::twa_succ_iterator*
     succ_iter(const spot::state* local_state) const;
 
+    /// true if s is the artificial initial state of the TGTA
+    bool
+    isArtificialInit(const spot::state* s) const;
+
+    /// The model steps of a changeset, from the ETF relations or built symbolically by the model.
+    its::Transition
+    getLocalsByChangeSet(bdd changeset) const;
+    /// The union of getLocalsByChangeSet over a set of changesets.
+    its::Transition
+    getLocalsByChangeSets(const std::vector<bdd> & changesets) const;
+
+    /// The saturation of an aggregate entering q through an arc accepting ac :
+    /// the least fixpoint under the self loops of q whose acceptance is subsumed by ac.
+    /// Computed once per (q, ac) and cached.
+    its::Transition
+    getSelfLoopSaturation(const spot::state* q, spot::acc_cond::mark_t ac) const;
+
+  private:
+    const its::EtfTestingType* model_labled_by_changesets_;
+    // the artificial initial state of the TGTA, computed once
+    const spot::state* init_;
+    // saturations by destination state then acceptance of the entering arc, keys are owned clones
+    mutable spot::state_map<std::map<spot::acc_cond::mark_t, its::Transition> > selfLoopSat_;
   };
 
 }
@@ -1,5 +1,8 @@
 #include "sogIts.hh"
 
+#include <climits>
+#include <algorithm>
+
 using namespace its;
 
 
@@ -8,6 +11,95 @@ using namespace its;
 
 
 
+// Set an observed atomic proposition, and compile it into a predicate over the main type.
+bool sogIts::setObservedAP (Label ap, int bddvar) {
+  if (! apOrder_.addVariable (ap,bddvar))
+    return false;
+
+  compiledAP cap;
+  cap.pred = buildPredicate(ap, getType());
+  cap.support = cap.pred.get_range();
+  if (cap.support.empty() || cap.support == Transition::full_range) {
+    cap.group = INT_MAX;
+  } else {
+    cap.group = *cap.support.begin();
+  }
+  trace << "Compiled AP " << ap << " reading from variable group " << cap.group << std::endl;
+  compiledAP_[bddvar] = cap;
+  return true;
+}
+
+// build the predicate for the AP "prop" over type "type", honoring place syntax.
+Transition sogIts::buildPredicate (Label prop, pType type) const {
+  if (! isPlaceSyntax ) {
+    char buff [prop.size()+1];
+    strcpy(buff,prop.c_str());
+    return type->getPredicate(buff);
+  } else {
+    char buff [prop.size()+3];
+    strcpy(buff,prop.c_str());
+    strcat(buff,"=1");
+    return type->getPredicate(buff);
+    // Used to be (before introduction of getPredicate in ITSModel)
+//       labels_t tau;
+//       tau.push_back(prop);
+//       hcond = type->getSuccs(tau);
+  }
+}
+
+// the selector for the AP of bdd variable "bvar" over type "type".
+Transition sogIts::getAPPredicate (int bvar, pType type) const {
+  if (type == getType()) {
+    std::map<int, compiledAP>::const_iterator it = compiledAP_.find(bvar);
+    if (it != compiledAP_.end())
+      return it->second.pred;
+  }
+  return buildPredicate(apOrder_.getLabel(bvar), type);
+}
+
+// the selector for a conjunction of literals, as a single conjunctive filter.
+Transition sogIts::getCubeSelector (bdd cube, pType type) const {
+  // (group, literal) : sorting gathers the AP that read the same variables,
+  // so the filters are composed level by level in the SDD.
+  std::vector<std::pair<int, Transition> > lits;
+  for (bdd cur = cube ; cur != bddtrue ; ) {
+    int bvar = bdd_var(cur);
+    Transition pred = getAPPredicate(bvar, type);
+    std::map<int, compiledAP>::const_iterator it = compiledAP_.find(bvar);
+    int group = (it != compiledAP_.end()) ? it->second.group : INT_MAX;
+    if (bdd_low(cur) == bddfalse) {
+      lits.push_back(std::make_pair(group, pred));
+      cur = bdd_high(cur);
+    } else {
+      lits.push_back(std::make_pair(group, ! pred));
+      cur = bdd_low(cur);
+    }
+  }
+  std::stable_sort(lits.begin(), lits.end(),
+		   [](const std::pair<int, Transition> & a, const std::pair<int, Transition> & b)
+		   { return a.first < b.first; });
+
+  Transition ret = Transition::id;
+  for (const auto & lit : lits) {
+    ret = lit.second & ret;
+  }
+  return ret;
+}
+
+// return true if aps is a conjunction of literals
+static bool isCube (bdd aps) {
+  for (bdd cur = aps ; cur != bddtrue ; ) {
+    if (bdd_low(cur) == bddfalse) {
+      cur = bdd_high(cur);
+    } else if (bdd_high(cur) == bddfalse) {
+      cur = bdd_low(cur);
+    } else {
+      return false;
+    }
+  }
+  return true;
+}
+
 // Atomic properties handling primitives
 // return a selector corresponding to the boolean formula over AP encoded as a bdd.
 Transition sogIts::getSelector(bdd aps) const {
@@ -28,31 +120,22 @@ its::Transition sogIts::getSelector(bdd aps, its::pType type) const {
     return Transition::id ;
   } else if (aps == bddfalse ) {
     return Transition::null;
+  } else if ( isCube(aps) ) {
+    // typically a full valuation of the AP, as built for aggregates
+    Transition ret = getCubeSelector(aps, type);
+    formulaCache.insert(it, aps.id());
+    it->second = ret;
+
+    trace << "Produced conjunctive filter :" << ret << std::endl;
+    return ret;
   } else {
     // a "real" node
     int bvar = bdd_var(aps);
-    Label prop = apOrder_.getLabel(bvar);
-
-    Transition hcond ;
-//    int len =type->getName().size();
-    if (! isPlaceSyntax ) {
-      char buff [prop.size()+1];
-      strcpy(buff,prop.c_str());
-      hcond = type->getPredicate(buff);
-    } else {
-      char buff [prop.size()+3];
-      strcpy(buff,prop.c_str());
-      strcat(buff,"=1");
-      hcond = type->getPredicate(buff);
-      // Used to be (before introduction of getPredicate in ITSModel)
-//       labels_t tau;
-//       tau.push_back(prop);
-//       hcond = type->getSuccs(tau);
-    }
+    Transition hcond = getAPPredicate(bvar, type);
 
     trace << "aps = " << aps  << std::endl;
     //      std::cerr << "Type = " << * (getInstance()->getType())  << std::endl;
-    trace << "prop = " << prop << std::endl ;
+    trace << "prop = " << apOrder_.getLabel(bvar) << std::endl ;
     trace << "hcond = "  << hcond << std::endl ;
 
     Transition ret ;
@@ -71,15 +154,264 @@ its::Transition sogIts::getSelector(bdd aps, its::pType type) const {
 }
 
 
+// The transition relation used to build aggregates : the model relation, with stuttering on deadlocks if requested.
+Transition sogIts::getNextRel () const {
+  if (transRel_ == Transition::id) {
+    transRel_ = getModelRel();
+
+    if (stutter_dead_) {
+      // add deadlocks
+      State dead;
+      if (! coi_) {
+	State reach = model.computeReachable();
+	dead = reach -  (model.getPredRel() (reach)); // i.e. add dead states that verify f
+      } else {
+	// deadlocks of the reduced system
+	State reach = fixpoint ( transRel_ + Transition::id, true ) (getInitialState());
+	dead = reach - (transRel_.invert(reach) (reach));
+      }
+      if (dead != State::null) {
+	std::cerr << "Computing Next relation with stutter on "<< dead.nbStates()  << "  deadlock states " << std::endl ;
+      }
+      deadRel_ = dead * Transition::id;
+      transRel_ = transRel_ + deadRel_;
+    }
+
+  }
+  return transRel_ ;
+}
+
+// The transition relation of the model, possibly sliced.
+Transition sogIts::getModelRel () const {
+  if (modelRel_ == Transition::null) {
+    if (coi_) {
+      computeConeOfInfluence();
+    } else {
+      modelRel_ = model.getNextRel();
+    }
+  }
+  return modelRel_;
+}
+
+// Compute the cone of influence of the observed AP.
+// A transition is kept if it touches a variable of the cone, and then all the variables it touches join the cone.
+// The kept transitions touch no variable outside the cone, so the removed ones form an independent subsystem :
+// its only observable effect is to allow stuttering forever, if it can run forever from the initial state.
+// In that case an identity step is added, so that stutter insensitive LTL verdicts are preserved.
+void sogIts::computeConeOfInfluence () const {
+  modelRel_ = model.getNextRel();
+
+  Transition::range_t cone;
+  for (const auto & cap : compiledAP_) {
+    if (cap.second.group == INT_MAX) {
+      std::cerr << "Unknown support for AP " << apOrder_.getLabel(cap.first) << ", cone of influence reduction disabled." << std::endl;
+      return;
+    }
+    cone.insert(cap.second.support.begin(), cap.second.support.end());
+  }
+
+  its::Type::namedTrs_t ntrans;
+  getType()->getNamedLocals(ntrans);
+  if (ntrans.empty()) {
+    std::cerr << "No named transitions in model, cone of influence reduction disabled." << std::endl;
+    return;
+  }
+
+  std::vector<bool> kept (ntrans.size(), false);
+  // fair transitions constrain the cycles, they stay with everything they touch
+  std::set<std::string> fair (weakFair_.begin(), weakFair_.end());
+  fair.insert(strongFair_.begin(), strongFair_.end());
+  for (size_t i = 0 ; i < ntrans.size() ; ++i) {
+    if (fair.find(ntrans[i].first) == fair.end())
+      continue;
+    Transition::range_t range = ntrans[i].second.get_range();
+    if (range == Transition::full_range) {
+      std::cerr << "Transition " << ntrans[i].first << " has unknown support, cone of influence reduction disabled." << std::endl;
+      return;
+    }
+    kept[i] = true;
+    cone.insert(range.begin(), range.end());
+  }
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (size_t i = 0 ; i < ntrans.size() ; ++i) {
+      if (kept[i])
+	continue;
+      Transition::range_t range = ntrans[i].second.get_range();
+      if (range == Transition::full_range) {
+	std::cerr << "Transition " << ntrans[i].first << " has unknown support, cone of influence reduction disabled." << std::endl;
+	return;
+      }
+      bool touches = false;
+      for (Transition::range_it it = range.begin() ; ! touches && it != range.end() ; ++it) {
+	touches = cone.find(*it) != cone.end();
+      }
+      if (touches) {
+	kept[i] = true;
+	changed = true;
+	cone.insert(range.begin(), range.end());
+      }
+    }
+  }
+
+  Transition relevant = Transition::null;
+  Transition irrelevant = Transition::null;
+  size_t nbkept = 0;
+  for (size_t i = 0 ; i < ntrans.size() ; ++i) {
+    if (kept[i]) {
+      relevant = relevant + ntrans[i].second;
+      ++nbkept;
+    } else {
+      irrelevant = irrelevant + ntrans[i].second;
+      slicedOut_.insert(ntrans[i].first);
+    }
+  }
+  std::cerr << "Cone of influence keeps " << nbkept << " of " << ntrans.size()
+	    << " transitions, touching " << cone.size() << " variables." << std::endl;
+
+  if (nbkept == ntrans.size()) {
+    return;
+  }
+
+  // can the removed subsystem run forever ?
+  State reachOut = fixpoint ( irrelevant + Transition::id, true ) (getInitialState());
+  State divOut = fixpoint ( irrelevant * Transition::id, true ) (reachOut);
+  if (divOut != State::null) {
+    trace << "Removed transitions may run forever, adding stuttering." << std::endl;
+    relevant = relevant + Transition::id;
+    modelRelStutter_ = true;
+  }
+  modelRel_ = relevant;
+  modelRelNamed_ = true;
+}
+
+Transition sogIts::getNextByChangeSet (bdd changeset) const {
+  auto memo = changesetRel_.find(changeset);
+  if (memo != changesetRel_.end())
+    return memo->second;
+
+  Transition res = Transition::null;
+  if (changeset == bddtrue) {
+    // AP absent from the changeset are unconstrained
+    res = getNextRel();
+  } else if (changeset != bddfalse) {
+    // bdd_setxor of the valuations holds the AP positively iff its value changes.
+    // The top AP filters the relations of the two cofactors, which are memoized as changesets
+    // over the AP below : the relation is built once per node of changeset, around a single getNextRel().
+    int var = bdd_var(changeset);
+    Transition p = getSelector(bdd_ithvar(var));
+    Transition np = getSelector(bdd_nithvar(var));
+    Transition changed = getNextByChangeSet(bdd_high(changeset));
+    if (changed != Transition::null)
+      res = res + (np & changed & p) + (p & changed & np);
+    Transition unchanged = getNextByChangeSet(bdd_low(changeset));
+    if (unchanged != Transition::null)
+      res = res + (p & unchanged & p) + (np & unchanged & np);
+  }
+  trace << "Built relation of changeset " << changeset << std::endl;
+  changesetRel_[changeset] = res;
+  return res;
+}
+
+Transition sogIts::getNamedTransition (const std::string & name) const {
+  its::Type::namedTrs_t ntrans;
+  getType()->getNamedLocals(ntrans);
+  Transition ret = Transition::null;
+  for (const auto & nt : ntrans) {
+    if (nt.first == name)
+      ret = ret + nt.second;
+  }
+  return ret;
+}
+
+// Split the next relation into transitions that touch a variable read by some observed AP, and the others.
+void sogIts::partitionNextRel () const {
+  if (isPartitioned_)
+    return;
+  isPartitioned_ = true;
+  visibleRel_ = getNextRel();
+  invisibleRel_ = Transition::null;
+
+  // the variables read by observed AP
+  Transition::range_t apvars;
+  for (const auto & cap : compiledAP_) {
+    if (cap.second.group == INT_MAX) {
+      // unknown support, any transition might be visible
+      trace << "Unknown support for AP " << apOrder_.getLabel(cap.first) << ", no invisible transitions." << std::endl;
+      return;
+    }
+    apvars.insert(cap.second.support.begin(), cap.second.support.end());
+  }
+
+  its::Type::namedTrs_t ntrans;
+  getType()->getNamedLocals(ntrans);
+  if (ntrans.empty()) {
+    return;
+  }
+
+  Transition vis = Transition::null;
+  Transition inv = Transition::null;
+  int nbinv = 0;
+  for (const auto & nt : ntrans) {
+    if (slicedOut_.find(nt.first) != slicedOut_.end()) {
+      // removed by the cone of influence
+      continue;
+    }
+    Transition::range_t range = nt.second.get_range();
+    bool visible = (range == Transition::full_range);
+    for (Transition::range_it it = range.begin() ; ! visible && it != range.end() ; ++it) {
+      visible = apvars.find(*it) != apvars.end();
+    }
+    if (visible) {
+      vis = vis + nt.second;
+    } else {
+      inv = inv + nt.second;
+      ++nbinv;
+    }
+  }
+  // stuttering on deadlocks, or added by the cone of influence, does not change any AP
+  getNextRel();
+  if (stutter_dead_) {
+    inv = inv + deadRel_;
+  }
+  if (modelRelStutter_) {
+    inv = inv + Transition::id;
+  }
+  trace << "Next relation partitioned : " << nbinv << " invisible transitions out of " << ntrans.size() << std::endl;
+
+  if (modelRelNamed_) {
+    // the next relation is built from the same named transitions : aggregate with the partition instead
+    transRel_ = vis + inv;
+  } else if (vis + inv != getNextRel()) {
+    // The locals of the type need not be the sum of its named transitions, and homomorphisms are only compared
+    // by structure : the remainder is unknown, keep the unpartitioned relation.
+    trace << "Named transitions are not known to cover the next relation, no invisible transitions." << std::endl;
+    return;
+  }
+
+  visibleRel_ = vis;
+  invisibleRel_ = inv;
+}
+
 // Saturate the provided states, while preserving the truth value of "cond"
 // The truth value of cond need not be homogeneous in the provided states.
 // fixpoint ( hcond & locals() + id ) ( hcond(s) )
 // Where hcond represents getSelector(cond)
 its::State sogIts::leastPostTestFixpoint ( State init, bdd cond ) const {
   Transition hcond = getSelector(cond);
-  Transition hnext = getNextRel();
+  Transition hinv = getInvisibleRel();
 
-  Transition sat = fixpoint ( (hcond &  hnext) + Transition::id , true ) & hcond;
+  Transition sat;
+  if (hinv == Transition::null) {
+    Transition hnext = getNextRel();
+    sat = fixpoint ( (hcond &  hnext) + Transition::id , true ) & hcond;
+  } else {
+    // invisible transitions preserve cond : saturate them without any selector
+    // fixpoint ( hcond & visible + fixpoint(invisible + id) ) ( hcond(s) )
+    Transition hvis = getVisibleRel();
+    sat = fixpoint ( (hcond & hvis) + fixpoint ( hinv + Transition::id, true ), true ) & hcond;
+  }
   trace << "Saturate (post) least fixpoint under conditions : " << sat << std::endl;
   return sat(init);
 }
@@ -89,14 +421,27 @@ its::State sogIts::leastPostTestFixpoint ( State init, bdd cond ) const {
 // fixpoint ( locals() & hcond + id ) (s)
 its::State sogIts::leastPreTestFixpoint ( its::State init, bdd cond ) const {
   Transition hcond = getSelector(cond);
-  Transition hnext = getNextRel();
+  Transition hinv = getInvisibleRel();
 
-  Transition sat = fixpoint ( ( hnext & hcond ) + Transition::id , true );
+  if (hinv == Transition::null) {
+    Transition hnext = getNextRel();
+    Transition sat = fixpoint ( ( hnext & hcond ) + Transition::id , true );
+
+    trace << "Saturate (pre) least fixpoint under conditions : " << sat << std::endl;
+    State res =  sat(init);
+
+    return res;
+  }
+
+  // The states satisfying cond are closed by invisible successors : saturate these
+  // as in leastPostTestFixpoint, then add the visible successors that leave cond.
+  Transition hvis = getVisibleRel();
+  Transition sat = fixpoint ( (hcond & hvis) + fixpoint ( hinv + Transition::id, true ), true ) & hcond;
 
   trace << "Saturate (pre) least fixpoint under conditions : " << sat << std::endl;
-  State res =  sat(init);
+  State incond = sat(init);
 
-  return res;
+  return init + incond + hvis (incond);
 }
 
 
@@ -108,7 +453,30 @@ State  sogIts::succSatisfying ( its::State init, bdd cond) const {
 // Return the set of divergent states in a set, using  (hcond & next) as transition relation
 State sogIts::getDivergent (State init, bdd cond) const {
   // build separately from application to avoid gc...
-  Transition fix = fixpoint ( (getSelector(cond) & model.getNextRel()) * Transition::id , true );
+  Transition fix = fixpoint ( (getSelector(cond) & getModelRel()) * Transition::id , true );
   return fix (init);
 }
 
+
+// Recursively split "states" on the truth value of vars[i], pruning empty branches.
+static void collectValuations (const sogIts & model, State states, const std::vector<int> & vars,
+			       size_t i, bdd cur, std::vector<bdd> & res) {
+  if (states == State::null)
+    return;
+  if (i == vars.size()) {
+    res.push_back(cur);
+    return;
+  }
+  bdd pos = bdd_ithvar(vars[i]);
+  bdd neg = bdd_nithvar(vars[i]);
+  collectValuations(model, model.getSelector(pos) (states), vars, i+1, cur & pos, res);
+  collectValuations(model, model.getSelector(neg) (states), vars, i+1, cur & neg, res);
+}
+
+// Compute the valuations of the AP of bdd variables "vars" that hold in some state of "states".
+std::vector<bdd> sogIts::getValuations (State states, const std::vector<int> & vars) const {
+  std::vector<bdd> res;
+  collectValuations(*this, states, vars, 0, bddtrue, res);
+  trace << "Found " << res.size() << " valuations of " << vars.size() << " AP in states." << std::endl;
+  return res;
+}
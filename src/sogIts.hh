@@ -1,11 +1,17 @@
 #ifndef ___SOGITS__HH__
 #define ___SOGITS__HH__
 
+#include <vector>
+#include <map>
+#include <set>
+#include <string>
+
 #include "its/Ordering.hh"
 
 #include "its/ITSModel.hh"
 // BuDDy package
 #include <bddx.h>
+#include <spot/misc/bddlt.hh>
 
 
 namespace sogits {
@@ -23,7 +29,10 @@ namespace sogits {
     SLAP_TGTA, // < The (Symbolic) Local Obs Graph algorithm using TGTA instead of TGBA.
     SOP_TGTA, // < The Symbolic Observation Product algorithm using TGTA instead of TGBA.
     SLAP_DTGTA, // < The (Symbolic) Local Obs Graph algorithm using DTGTA (Don't care TGTA) instead of TGBA.
-    SOP_DTGTA  // < The Symbolic Observation Product algorithm using DTGTA (Don't care TGTA) instead of TGBA.
+    SOP_DTGTA,  // < The Symbolic Observation Product algorithm using DTGTA (Don't care TGTA) instead of TGBA.
+    FS_OWCTY_BWD, // < The fully symbolic approach: One-Way catch them Young with pre-images.
+    FS_EL_BWD, // < The fully symbolic approach: Emerson-Lei variant with pre-images.
+    FS_LOCKSTEP // < The fully symbolic approach: lockstep SCC decomposition.
   };
 }
 
@@ -39,16 +48,65 @@ class sogIts {
   mutable formCache_t formulaCache;
 
   mutable its::Transition transRel_;
+  // the stuttering on deadlocks added to transRel_ (if stutter_dead_)
+  mutable its::Transition deadRel_;
    // Defines a mapping from atomic property name to bdd variable index
   its::VarOrder apOrder_;
 
+  // An observed AP, compiled once into a selector over the main type of the model.
+  struct compiledAP {
+    // the selector for states where the AP holds
+    its::Transition pred;
+    // the model variables read by the predicate
+    its::Transition::range_t support;
+    // the variable used to group AP reading the same part of the state, INT_MAX if the support is unknown
+    int group;
+  };
+  // compiled AP indexed by bdd variable
+  std::map<int, compiledAP> compiledAP_;
+
+  // Partition of the next relation : invisible transitions cannot change the truth value of any
+  // observed AP (they do not touch the variables the AP read), visible ones might.
+  // Both are null until partitionNextRel is invoked.
+  mutable its::Transition visibleRel_;
+  mutable its::Transition invisibleRel_;
+  mutable bool isPartitioned_;
+  void partitionNextRel () const;
+
+  // build the predicate for the AP "prop" over type "type", honoring place syntax.
+  its::Transition buildPredicate (Label prop, its::pType type) const;
+  // the selector for the AP of bdd variable "bvar" over type "type".
+  its::Transition getAPPredicate (int bvar, its::pType type) const;
+  // the selector for a conjunction of literals (a cube), built as a single
+  // conjunctive filter with AP grouped by the model variables they read.
+  its::Transition getCubeSelector (bdd cube, its::pType type) const;
+
   // True if for ascending compatibility issues, atomic properties should be reinterpreted
   // as if they were just the names of places, instead of comparisons.
   // e.g. reinterpret AP  "Idle0" as "Idle0 = 1"
   bool isPlaceSyntax;
   bool stutter_dead_;
+
+  // cone of influence reduction
+  bool coi_;
+  // the model relation, possibly sliced, null until computed
+  mutable its::Transition modelRel_;
+  // the names of the transitions removed by the cone of influence
+  mutable std::set<std::string> slicedOut_;
+  // true if the cone of influence built modelRel_ as the sum of the kept named transitions, plus identity if modelRelStutter_
+  mutable bool modelRelNamed_;
+  mutable bool modelRelStutter_;
+  // compute modelRel_ as the cone of influence of the observed AP.
+  void computeConeOfInfluence () const;
+
+  // memoized results of getNextByChangeSet, also for the cofactors of the changesets asked
+  mutable std::map<bdd, its::Transition, spot::bdd_less_than> changesetRel_;
+
+  // names of the model transitions under weak and strong fairness
+  its::labels_t weakFair_;
+  its::labels_t strongFair_;
 public :
-  sogIts (const its::ITSModel & m) : model(m),transRel_(its::Transition::id),isPlaceSyntax(false),stutter_dead_(false) {};
+  sogIts (const its::ITSModel & m) : model(m),transRel_(its::Transition::id),deadRel_(its::Transition::null),visibleRel_(its::Transition::null),invisibleRel_(its::Transition::null),isPartitioned_(false),isPlaceSyntax(false),stutter_dead_(false),coi_(false),modelRel_(its::Transition::null),modelRelNamed_(false),modelRelStutter_(false) {};
 
   // True if for ascending compatibility issues, atomic properties should be reinterpreted
   // as if they were just the names of places, instead of comparisons.
@@ -82,32 +140,59 @@ public :
   // Return the set of divergent states in a set, using  (hcond & next) as transition relation
   its::State getDivergent (its::State init, bdd cond) const;
 
+  // Compute the valuations of the AP of bdd variables "vars" that hold in some state of "states".
+  // Returns one full conjunction over "vars" per valuation present (bddtrue if vars is empty).
+  // The set is split on each AP in turn, pruning empty branches : each level holds at most one branch per valuation present,
+  // so the cost is O(|valuations| x |vars|) selector applications, rather than 2^|vars|.
+  std::vector<bdd> getValuations (its::State states, const std::vector<int> & vars) const;
+
   its::State getInitialState () const { return model.getInitialState() ; }
 
   its::pType getType() const { return model.getInstance()->getType() ; }
 
-  its::Transition getNextRel () const {
-    if (transRel_ == its::Transition::id) {
-      transRel_ = model.getNextRel();
-   
-      if (stutter_dead_) {
-	// add deadlocks  
-	its::State reach = model.computeReachable();
-	its::State dead = reach -  (model.getPredRel() (reach)); // i.e. add dead states that verify f
-	if (dead != its::State::null) {
-	  std::cerr << "Computing Next relation with stutter on "<< dead.nbStates()  << "  deadlock states " << std::endl ;
-	}
-	transRel_ = transRel_ +(dead * its::Transition::id);
-      }
-
-    }
-    return transRel_ ;
-  }
+  // The transition relation used to build aggregates : the model relation, with stuttering on deadlocks if requested.
+  its::Transition getNextRel () const ;
+
+  // The transition relation of the model : model.getNextRel(), or its cone of influence w.r.t. the observed AP.
+  // Precondition : all observed AP are set.
+  its::Transition getModelRel () const ;
+
+  // Enable cone of influence reduction : transitions that cannot influence (even transitively) the
+  // variables read by observed AP are removed from the relation; their variables are thus frozen to their initial value.
+  void setConeOfInfluence (bool val) { coi_ = val; }
+  bool isConeOfInfluence () const { return coi_; }
+
+  // Fairness assumptions on model transitions, given by name : a weakly fair transition cannot stay
+  // enabled forever without firing, a strongly fair one cannot be enabled infinitely often without firing.
+  // Fair transitions are kept by the cone of influence.
+  void setFairness (const its::labels_t & weak, const its::labels_t & strong) { weakFair_ = weak; strongFair_ = strong; }
+  const its::labels_t & getWeakFairness () const { return weakFair_; }
+  const its::labels_t & getStrongFairness () const { return strongFair_; }
+  bool hasFairness () const { return ! weakFair_.empty() || ! strongFair_.empty(); }
+
+  // The union of the model transitions with this name, Transition::null if there is none.
+  its::Transition getNamedTransition (const std::string & name) const;
+
+  // The steps of getNextRel() whose changeset, bdd_setxor of the AP valuations of source and target
+  // as in TGTA, implies changeset. Built symbolically along the nodes of changeset, without any reachability
+  // computation : each node filters the relations of its cofactors by "AP changed" or "AP unchanged" selectors,
+  // so the size of the relation is linear in the number of nodes of changeset.
+  // So that TGTA products work with any kind of model.
+  // Precondition : all observed AP are set.
+  its::Transition getNextByChangeSet (bdd changeset) const;
+
+  // The part of getNextRel() that may change the truth value of some observed AP.
+  // Together with getInvisibleRel(), it always covers getNextRel() ; they may overlap.
+  // Precondition : all observed AP are set.
+  its::Transition getVisibleRel () const { partitionNextRel(); return visibleRel_; }
+
+  // The part of getNextRel() that preserves the truth value of all observed AP, null if unknown.
+  // Precondition : all observed AP are set.
+  its::Transition getInvisibleRel () const { partitionNextRel(); return invisibleRel_; }
 
   // Set an observed atomic proposition : the string corresponding to the AP identifier is then related to the bdd var of index
-  bool setObservedAP (Label ap, int bddvar) {
-    return apOrder_.addVariable (ap,bddvar);
-  }
+  // The AP is compiled into its predicate once and for all.
+  bool setObservedAP (Label ap, int bddvar);
 
 
 };
@@ -0,0 +1,103 @@
+#include "sogcache.hh"
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <cstdint>
+#include <cstdio>
+
+#include <spot/parseaut/public.hh>
+#include <spot/twaalgos/hoa.hh>
+
+// #define trace std::cerr
+#define trace if (0) std::cerr
+
+namespace sogits {
+
+  // FNV-1a, 64 bits : stable across runs and platforms, unlike std::hash
+  static uint64_t fnv_hash (const char * data, size_t len, uint64_t h = 14695981039346656037ULL) {
+    for (size_t i = 0; i < len; ++i) {
+      h ^= (unsigned char) data[i];
+      h *= 1099511628211ULL;
+    }
+    return h;
+  }
+
+  static std::string to_hex (uint64_t h) {
+    std::ostringstream os;
+    os << std::hex << std::setw(16) << std::setfill('0') << h;
+    return os.str();
+  }
+
+  sog_cache::sog_cache (const std::string & dir, const std::string & modelFile) : dir_(dir) {
+    std::ifstream in (modelFile.c_str(), std::ios::binary);
+    if (! in) {
+      std::cerr << "Cannot read model file " << modelFile << " to compute its SOG cache key, cache disabled." << std::endl;
+      return;
+    }
+    uint64_t h = 14695981039346656037ULL;
+    char buff [1 << 16];
+    while (in) {
+      in.read(buff, sizeof(buff));
+      h = fnv_hash(buff, in.gcount(), h);
+    }
+    modelHash_ = to_hex(h);
+  }
+
+  std::string sog_cache::getEntry (const spot::atomic_prop_set & aps, sog_product_type type,
+				   bool stutter_dead, bool isPlaceSyntax, bool coi) const {
+    // atomic_prop_set is ordered, so the key does not depend on the formula
+    std::ostringstream key;
+    for (auto ap : aps) {
+      key << ap.ap_name() << '\0';
+    }
+    key << (int) type << '/' << stutter_dead << '/' << isPlaceSyntax << '/' << coi;
+    std::string k = key.str();
+
+    return dir_ + "/sog-" + modelHash_ + "-" + to_hex(fnv_hash(k.c_str(), k.size())) + ".hoa";
+  }
+
+  spot::twa_graph_ptr sog_cache::load (const std::string & entry, const spot::bdd_dict_ptr & dict) const {
+    std::ifstream test (entry.c_str());
+    if (! test) {
+      trace << "No SOG cache entry " << entry << std::endl;
+      return nullptr;
+    }
+    test.close();
+
+    spot::parsed_aut_ptr pa = spot::parse_aut(entry, dict);
+    if (pa->format_errors(std::cerr) || pa->aborted) {
+      std::cerr << "Ignoring corrupted SOG cache entry " << entry << std::endl;
+      return nullptr;
+    }
+    std::cout << "Loaded observation graph from cache " << entry << std::endl;
+    return pa->aut;
+  }
+
+  bool sog_cache::save (const std::string & entry, const spot::const_twa_graph_ptr & sog) const {
+    // write to a temporary file then rename, so that a concurrent or interrupted run
+    // never observes a partial entry
+    std::string tmp = entry + ".tmp";
+    {
+      std::ofstream out (tmp.c_str());
+      if (! out) {
+	std::cerr << "Cannot write SOG cache entry " << entry << std::endl;
+	return false;
+      }
+      spot::print_hoa(out, sog);
+      out << std::endl;
+      if (! out) {
+	std::cerr << "Error writing SOG cache entry " << entry << std::endl;
+	return false;
+      }
+    }
+    if (std::rename(tmp.c_str(), entry.c_str()) != 0) {
+      std::cerr << "Cannot write SOG cache entry " << entry << std::endl;
+      return false;
+    }
+    std::cout << "Stored observation graph in cache " << entry << std::endl;
+    return true;
+  }
+
+}
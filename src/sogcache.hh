@@ -0,0 +1,44 @@
+#ifndef SOG_CACHE_HH
+#define SOG_CACHE_HH
+
+#include <string>
+
+#include <spot/twa/twagraph.hh>
+#include <spot/tl/apcollect.hh>
+
+#include "sogIts.hh"
+
+namespace sogits {
+
+  /** An on-disk cache of fully built observation graphs.
+   *  An entry is keyed by a hash of the model file, the set of observed AP,
+   *  the kind of SOG and the options that change its shape (stutter on deadlocks, place syntax, cone of influence).
+   *  The graph is stored in HOA format : edges carry the AP valuation of their target aggregate,
+   *  divergence is kept as the self looping div states of the SOG. */
+  class sog_cache {
+    // the folder holding the cache entries
+    std::string dir_;
+    // hash of the model file contents, as an hex string
+    std::string modelHash_;
+
+  public :
+    sog_cache (const std::string & dir, const std::string & modelFile);
+
+    /// true if the model file could be read and hashed
+    bool isValid () const { return ! modelHash_.empty(); }
+
+    /// compute the path of the cache entry for a given observation graph
+    std::string getEntry (const spot::atomic_prop_set & aps, sog_product_type type,
+			  bool stutter_dead, bool isPlaceSyntax, bool coi) const;
+
+    /// load an entry, returns nullptr if the entry does not exist or cannot be parsed.
+    /// the AP are registered in the provided dictionary.
+    spot::twa_graph_ptr load (const std::string & entry, const spot::bdd_dict_ptr & dict) const;
+
+    /// store a fully built observation graph, returns false on IO error.
+    bool save (const std::string & entry, const spot::const_twa_graph_ptr & sog) const;
+  };
+
+}
+
+#endif
@@ -1,4 +1,19 @@
 #include <iostream>
+#include <atomic>
+#include <algorithm>
+#include <new>
+#include <cerrno>
+#include <cstdio>
+#include <unistd.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <poll.h>
+#include <deque>
+#include <map>
+#include <set>
+#include <sstream>
+#include <cstdint>
 
 #include <spot/tl/formula.hh>
 #include <spot/tl/apcollect.hh>
@@ -22,8 +37,13 @@
 #include <spot/ta/tgtaproduct.hh>
 #include "slaptgta.cpp"
 #include "dsogtgta.hh"
+#include "swarm.hh"
+#include "scc_parallel.hh"
+#include <spot/twaalgos/sccinfo.hh>
 
 #include "ddd/statistic.hpp"
+#include "ddd/DDD.h"
+#include "ddd/SDD.h"
 #include <spot/twaalgos/postproc.hh>
 
 // #define trace std::cerr
@@ -42,9 +62,10 @@ namespace sogits
       }
 
 
-    if (sogtype == FS_OWCTY || sogtype == FS_EL || sogtype == FS_OWCTY_TGTA)
+    if (sogtype == FS_OWCTY || sogtype == FS_EL || sogtype == FS_OWCTY_TGTA
+	|| sogtype == FS_OWCTY_BWD || sogtype == FS_EL_BWD || sogtype == FS_LOCKSTEP)
       {	
-        return fs_model_check(sogtype == FS_OWCTY || sogtype == FS_OWCTY_TGTA);
+        return fs_model_check(sogtype);
       }
 
     const char* err;
@@ -72,10 +93,10 @@ namespace sogits
     switch (sogtype)
       {
     case PLAIN_SOG:
-      prod = otf_product(a_, systgba_);
+      prod = otf_product(a_, getObservationGraph(sogtype));
       break;
     case BCZ99:
-      prod = otf_product(a_, systgba_);
+      prod = otf_product(a_, getObservationGraph(sogtype));
       break;
     case SLAP_NOFS:
       prod = std::make_shared<slap::slap_tgba>(a_, *sogModel_, NOFS);
@@ -105,6 +126,9 @@ namespace sogits
     case FS_OWCTY:
     case FS_EL:
     case FS_OWCTY_TGTA:
+    case FS_OWCTY_BWD:
+    case FS_EL_BWD:
+    case FS_LOCKSTEP:
       // (case treated for compiler warning) should not happen, tested at top of function
       return false;
       }
@@ -115,13 +139,387 @@ namespace sogits
         exit(0);
       }
 
-    auto ec = echeck_inst->instantiate(prod);
     timers.stop("construction");
 
+    if (scc_parallel_ > 1)
+      {
+	if (sogtype == SLAP_NOFS || sogtype == SLAP_FST || sogtype == SLAP_FSA || sogtype == SOP)
+	  return scc_parallel_check(echeck_inst, prod);
+	std::cerr << "SCC parallel exploration is only available for SLAP and SOP products, ignored." << std::endl;
+      }
+
+    if (swarm_ > 1)
+      return swarm_check(echeck_inst, prod);
+
+    auto ec = echeck_inst->instantiate(prod);
+
     timers.start("emptiness check");
     auto res = ec->check();
     timers.stop("emptiness check");
 
+    return report_check(ec, res);
+  } //
+
+  bool
+  LTLChecker::swarm_check(const spot::emptiness_check_instantiator_ptr & echeck_inst,
+			  const spot::const_twa_ptr & prod)
+  {
+    // the first worker to conclude registers here, visible to all processes
+    void * shared = mmap(nullptr, sizeof(std::atomic<int>), PROT_READ | PROT_WRITE,
+			 MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (shared == MAP_FAILED)
+      {
+	perror("mmap");
+	exit(1);
+      }
+    std::atomic<int> * winner = new (shared) std::atomic<int>(-1);
+
+    // don't let the workers inherit pending output
+    std::cout.flush();
+    std::cerr.flush();
+
+    std::vector<pid_t> workers;
+    for (unsigned i = 0; i < swarm_; ++i)
+      {
+	pid_t pid = fork();
+	if (pid < 0)
+	  {
+	    perror("fork");
+	    break;
+	  }
+	if (pid == 0)
+	  {
+	    // worker 0 keeps the natural exploration order
+	    spot::const_twa_ptr p = prod;
+	    if (i > 0)
+	      p = std::make_shared<swarm_twa>(prod, i);
+	    auto ec = echeck_inst->instantiate(p);
+
+	    timers.start("emptiness check");
+	    auto res = ec->check();
+	    timers.stop("emptiness check");
+
+	    int expected = -1;
+	    if (! winner->compare_exchange_strong(expected, (int) i))
+	      _exit(2);
+	    std::cout << "Swarm worker " << i << " of " << swarm_ << " concluded first." << std::endl;
+	    bool found = report_check(ec, res);
+	    std::cout.flush();
+	    _exit(found ? 1 : 0);
+	  }
+	workers.push_back(pid);
+      }
+
+    // every check is complete, so the first worker to conclude gives the verdict
+    bool conclusive = false;
+    bool found = false;
+    size_t alive = workers.size();
+    while (alive > 0)
+      {
+	int status;
+	pid_t pid = waitpid(-1, &status, 0);
+	if (pid < 0)
+	  {
+	    if (errno == EINTR)
+	      continue;
+	    break;
+	  }
+	auto w = std::find(workers.begin(), workers.end(), pid);
+	if (w == workers.end())
+	  continue;
+	*w = 0;
+	--alive;
+	int win = winner->load();
+	if (! conclusive && win == w - workers.begin()
+	    && WIFEXITED(status) && WEXITSTATUS(status) <= 1)
+	  {
+	    conclusive = true;
+	    found = WEXITSTATUS(status) == 1;
+	    for (pid_t other : workers)
+	      if (other != 0)
+		kill(other, SIGKILL);
+	  }
+      }
+    munmap(shared, sizeof(std::atomic<int>));
+
+    if (! conclusive)
+      {
+	std::cerr << "No swarm worker completed the emptiness check." << std::endl;
+	exit(1);
+      }
+    return found;
+  }
+
+  // Digests of decision diagrams, computed from variables, values and the digests of successors rather than
+  // from node addresses, so that processes forked from the same parent agree on them.
+  static uint64_t dd_mix (uint64_t h, uint64_t v)
+  {
+    uint64_t z = h * 0x100000001b3ULL + v + 0x9e3779b97f4a7c15ULL;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+  }
+
+  static uint64_t ddd_digest (const GDDD & d, std::map<GDDD, uint64_t> & memo)
+  {
+    if (d == GDDD::one)
+      return 1;
+    if (d == GDDD::null)
+      return 2;
+    if (d == GDDD::top)
+      return 3;
+    auto m = memo.find(d);
+    if (m != memo.end())
+      return m->second;
+    // arcs of a DDD are sorted by value
+    uint64_t h = dd_mix(4, d.variable());
+    for (GDDD::const_iterator it = d.begin(); it != d.end(); ++it)
+      h = dd_mix(dd_mix(h, it->first), ddd_digest(it->second, memo));
+    memo[d] = h;
+    return h;
+  }
+
+  // false if an arc is labeled by a data set that is neither an SDD nor a DDD
+  static bool sdd_digest (const GSDD & s, std::map<GSDD, uint64_t> & memo,
+			  std::map<GDDD, uint64_t> & dddMemo, uint64_t & res)
+  {
+    if (s == GSDD::one || s == GSDD::null || s == GSDD::top)
+      {
+	res = s == GSDD::one ? 1 : (s == GSDD::null ? 2 : 3);
+	return true;
+      }
+    auto m = memo.find(s);
+    if (m != memo.end())
+      {
+	res = m->second;
+	return true;
+      }
+    // the order of the arcs of an SDD depends on addresses, sort their digests
+    std::vector<std::pair<uint64_t, uint64_t> > arcs;
+    for (GSDD::const_iterator it = s.begin(); it != s.end(); ++it)
+      {
+	uint64_t val, succ;
+	if (const SDD * sval = dynamic_cast<const SDD *>(it->first))
+	  {
+	    if (! sdd_digest(*sval, memo, dddMemo, val))
+	      return false;
+	  }
+	else if (const DDD * dval = dynamic_cast<const DDD *>(it->first))
+	  val = dd_mix(5, ddd_digest(*dval, dddMemo));
+	else
+	  return false;
+	if (! sdd_digest(it->second, memo, dddMemo, succ))
+	  return false;
+	arcs.push_back(std::make_pair(val, succ));
+      }
+    std::sort(arcs.begin(), arcs.end());
+    uint64_t h = dd_mix(6, s.variable());
+    for (auto & a : arcs)
+      h = dd_mix(dd_mix(h, a.first), a.second);
+    memo[s] = h;
+    res = h;
+    return true;
+  }
+
+  bool
+  LTLChecker::scc_parallel_check(const spot::emptiness_check_instantiator_ptr & echeck_inst,
+				 const spot::const_twa_ptr & prod)
+  {
+    // ag_ is the left operand of both SLAP and SOP products
+    spot::scc_info si (ag_);
+    scc_task_twa::scc_of_t sccOf = [&] (const spot::state * s) -> int {
+      const spot::state * q = nullptr;
+      if (auto ss = dynamic_cast<const slap::slap_state*>(s))
+	q = ss->left();
+      else if (auto ds = dynamic_cast<const dsog::dsog_state*>(s))
+	q = ds->left();
+      if (! q)
+	return -1;
+      return si.scc_of(ag_->state_number(q));
+    };
+    scc_task_twa::is_useful_t isUseful = [&] (int scc) { return si.is_useful_scc(scc); };
+    // automaton state and digest of the aggregate, "-" if the aggregate cannot be digested.
+    // Two distinct aggregates of a product only share a key if their 64 bit digests collide.
+    scc_task_twa::key_of_t keyOf = [&] (const spot::state * s) -> std::string {
+      const spot::state * q = nullptr;
+      its::State agg;
+      if (auto ss = dynamic_cast<const slap::slap_state*>(s))
+	{
+	  q = ss->left();
+	  agg = ss->right();
+	}
+      else if (auto ds = dynamic_cast<const dsog::dsog_state*>(s))
+	{
+	  q = ds->left();
+	  agg = ds->right();
+	}
+      std::map<GSDD, uint64_t> memo;
+      std::map<GDDD, uint64_t> dddMemo;
+      uint64_t digest;
+      if (! q || ! sdd_digest(agg, memo, dddMemo, digest))
+	return "-";
+      std::ostringstream key;
+      key << ag_->state_number(q) << ":" << std::hex << digest;
+      return key.str();
+    };
+
+    struct task_t {
+      int scc;
+      succ_path_t path;
+    };
+    // the first worker to find an accepting run registers here, the others stay silent
+    void * shared = mmap(nullptr, sizeof(std::atomic<int>), PROT_READ | PROT_WRITE,
+			 MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (shared == MAP_FAILED)
+      {
+	perror("mmap");
+	exit(1);
+      }
+    std::atomic<int> * winner = new (shared) std::atomic<int>(-1);
+
+    std::deque<task_t> todo;
+    // the keys of the entries already scheduled, the same aggregate may be entered through several paths
+    std::set<std::string> seen;
+    const spot::state * init = prod->get_init_state();
+    todo.push_back({ sccOf(init), succ_path_t() });
+    init->destroy();
+
+    struct worker_t {
+      pid_t pid;
+      std::string buff;
+    };
+    // by read end of the pipe of the worker
+    std::map<int, worker_t> running;
+    size_t nbtasks = 0;
+    bool found = false;
+
+    while (! found && (! todo.empty() || ! running.empty()))
+      {
+	while (running.size() < scc_parallel_ && ! todo.empty())
+	  {
+	    task_t task = todo.front();
+	    todo.pop_front();
+	    int fds[2];
+	    if (pipe(fds) != 0)
+	      {
+		perror("pipe");
+		exit(1);
+	      }
+	    std::cout.flush();
+	    std::cerr.flush();
+	    pid_t pid = fork();
+	    if (pid < 0)
+	      {
+		perror("fork");
+		exit(1);
+	      }
+	    if (pid == 0)
+	      {
+		close(fds[0]);
+		FILE * out = fdopen(fds[1], "w");
+		const spot::state * entry = replay_path(prod, task.path);
+		auto local = std::make_shared<scc_task_twa>(prod, task.scc, entry, task.path,
+							   sccOf, isUseful, keyOf, out);
+		auto ec = echeck_inst->instantiate(local);
+
+		timers.start("emptiness check");
+		auto res = ec->check();
+		timers.stop("emptiness check");
+
+		fclose(out);
+		if (! res)
+		  _exit(0);
+		int expected = -1;
+		if (! winner->compare_exchange_strong(expected, (int) nbtasks))
+		  _exit(1);
+		std::cout << "Worker on automaton SCC " << task.scc
+			  << " concluded first, from an entry aggregate of that SCC." << std::endl;
+		report_check(ec, res);
+		std::cout.flush();
+		_exit(1);
+	      }
+	    close(fds[1]);
+	    running[fds[0]] = { pid, std::string() };
+	    ++nbtasks;
+	  }
+
+	std::vector<pollfd> polled;
+	for (auto & w : running)
+	  polled.push_back({ w.first, POLLIN, 0 });
+	if (poll(polled.data(), polled.size(), -1) < 0)
+	  {
+	    if (errno == EINTR)
+	      continue;
+	    perror("poll");
+	    exit(1);
+	  }
+
+	for (auto & p : polled)
+	  {
+	    if (! p.revents)
+	      continue;
+	    worker_t & w = running[p.fd];
+	    char buff [4096];
+	    ssize_t n = read(p.fd, buff, sizeof(buff));
+	    if (n > 0)
+	      {
+		w.buff.append(buff, n);
+		// each complete line is a new entry : "<scc> <key> <path...>", only the worker replays the path
+		size_t eol;
+		while ((eol = w.buff.find('\n')) != std::string::npos)
+		  {
+		    std::istringstream line (w.buff.substr(0, eol));
+		    w.buff.erase(0, eol + 1);
+		    task_t task;
+		    std::string key;
+		    line >> task.scc >> key;
+		    unsigned pos;
+		    while (line >> pos)
+		      task.path.push_back(pos);
+		    if (key == "-" || seen.insert(key).second)
+		      todo.push_back(task);
+		  }
+		continue;
+	      }
+	    if (n < 0 && errno == EINTR)
+	      continue;
+	    // end of the worker
+	    close(p.fd);
+	    int status;
+	    waitpid(w.pid, &status, 0);
+	    running.erase(p.fd);
+	    if (WIFEXITED(status) && WEXITSTATUS(status) == 1)
+	      found = true;
+	    else if (! WIFEXITED(status) || WEXITSTATUS(status) != 0)
+	      {
+		std::cerr << "SCC parallel worker failed, emptiness check aborted." << std::endl;
+		for (auto & other : running)
+		  kill(other.second.pid, SIGKILL);
+		exit(1);
+	      }
+	  }
+      }
+
+    // an accepting run is enough, stop the others
+    for (auto & w : running)
+      {
+	kill(w.second.pid, SIGKILL);
+	close(w.first);
+	waitpid(w.second.pid, nullptr, 0);
+      }
+    munmap(shared, sizeof(std::atomic<int>));
+
+    std::cout << "SCC parallel exploration ran " << nbtasks << " tasks over "
+	      << si.scc_count() << " automaton SCCs." << std::endl;
+    if (! found)
+      std::cout << "no accepting run found" << std::endl;
+    return found;
+  }
+
+  bool
+  LTLChecker::report_check(const spot::emptiness_check_ptr & ec,
+			   const spot::emptiness_check_result_ptr & res)
+  {
     ec->print_stats(std::cout);
     //  timers.print(std::cout);
     const spot::timer& tec = timers.timer("emptiness check");
@@ -156,6 +554,27 @@ namespace sogits
       }
   } //
 
+  spot::const_twa_ptr
+  LTLChecker::getObservationGraph (sog_product_type sogtype)
+  {
+    if (! sogCache_ || ! sogCache_->isValid())
+      return systgba_;
+
+    std::string entry = sogCache_->getEntry(*sap_, sogtype, stutter_dead_, isPlaceSyntax, coi_);
+    spot::twa_graph_ptr sog = sogCache_->load(entry, dict_);
+    if (! sog)
+      {
+	// explore the whole SOG once, so that it can be stored
+	timers.start("SOG construction");
+	sog = spot::make_twa_graph(systgba_, spot::twa::prop_set::all());
+	timers.stop("SOG construction");
+	std::cout << "Built observation graph with " << sog->num_states() << " states and "
+		  << sog->num_edges() << " edges." << std::endl;
+	sogCache_->save(entry, sog);
+      }
+    return sog;
+  }
+
   void LTLChecker::setAutomaton (spot::twa_graph_ptr  aut, spot::bdd_dict_ptr   dict) {
      	ag_ = aut;
      	a_ = ag_;
@@ -170,28 +589,69 @@ namespace sogits
   }
 
   bool
-  LTLChecker::fs_model_check(bool isOWCTY)
+  LTLChecker::fs_model_check(sog_product_type sogtype)
   {
     its::fsltlModel * fsmodel = (its::fsltlModel *) model_;
     fsmodel->setSogModel(sogModel_);
+    fsmodel->setDecisionOnly(fs_decision_);
+    fsmodel->setSCCDecomposition(fs_scc_);
+    fsmodel->setStutterSaturation(fs_stutter_);
+    fsmodel->setWitness(ce_expected_);
+    fsmodel->setHullStats(fs_stats_);
+    fsmodel->setAdaptiveOrder(! fs_fixed_order_);
+    fsmodel->setTgbaEncoding(fs_encoding_);
+    fsmodel->setTgbaOnTop(fs_tgba_top_);
     fsmodel->declareType(a_);
 
-    fsmodel->buildComposedSystem();
+    if (! fsmodel->buildComposedSystem()) {
+        std::cerr << "Could not build the fully symbolic product, aborting." << std::endl;
+        exit(1);
+    }
 
     its::State res;
-    if (isOWCTY)
-      {
-        res = fsmodel->findSCC_owcty();
-      }
-    else
+    switch (sogtype)
       {
+      case FS_EL:
         res = fsmodel->findSCC_el();
+        break;
+      case FS_OWCTY_BWD:
+        res = fsmodel->findSCC_owcty_bwd();
+        break;
+      case FS_EL_BWD:
+        res = fsmodel->findSCC_el_bwd();
+        break;
+      case FS_LOCKSTEP:
+        res = fsmodel->findSCC_lockstep();
+        break;
+      default:
+        res = fsmodel->findSCC_owcty();
+        break;
       }
     Statistic S = Statistic(res, ltl_string_, CSV); // can also use LATEX instead of CSV
     S.print_table(std::cout);
 
+    const its::fsltlModel::hull_stats_t & stats = fsmodel->getLastStats();
+    if (stats.iterations > 0)
+      {
+        std::cout << "SCC hull : " << stats.iterations << " iterations, "
+                  << stats.closures << " closures applied, states removed per acceptance set :";
+        for (const auto & r : stats.removed)
+          std::cout << " " << r.first << "=" << r.second;
+        std::cout << std::endl;
+      }
+
     if (res != its::State::null)
-      std::cout << "an accepting run exists" << std::endl;
+      {
+        std::cout << "an accepting run exists" << std::endl;
+        if (ce_expected_)
+          {
+            timers.start("witness");
+            // forward hulls are closed by successors of fair SCC, backward ones by predecessors
+            bool isForwardHull = (sogtype == FS_OWCTY || sogtype == FS_EL || sogtype == FS_OWCTY_TGTA);
+            fsmodel->printWitness(res, isForwardHull, std::cout);
+            timers.stop("witness");
+          }
+      }
     else
       std::cout << "no accepting run found" << std::endl;
     return  (res != its::State::null);
@@ -201,6 +661,8 @@ namespace sogits
 	  sogModel_ = new sogIts(*model_);
 	  sogModel_->setStutterDeadlock(stutter_dead_);
 	  sogModel_->setPlaceSyntax(isPlaceSyntax);
+	  sogModel_->setConeOfInfluence(coi_);
+	  sogModel_->setFairness(weak_fair_, strong_fair_);
 
 
 	  systgba_ = std::make_shared<sog_tgba>(*sogModel_, dict_, sogtype);
@@ -230,7 +692,8 @@ namespace sogits
 
 			  its::fsltlTestingModel * testingModel =
 					  dynamic_cast<its::fsltlTestingModel*> (model_);
-			  if (testingModel)
+			  // only ETF models have a testing type, other models build changesets symbolically
+			  if (testingModel && testingModel->getTestingModel())
 			  {
 				  testingModel->getTestingModel()->setObservedAP(a.ap_name(),
 						  varnum);
@@ -264,6 +727,11 @@ namespace sogits
 
     	// TGBA post processing (minimization of TGBA using simulation(bi-simulation), cosimulation, iterated_simulations,...)
     	spot::postprocessor post;
+    	if (fs_parity_ && (sogtype == FS_OWCTY || sogtype == FS_EL || sogtype == FS_OWCTY_BWD
+    			   || sogtype == FS_EL_BWD || sogtype == FS_LOCKSTEP)) {
+    		// the fully symbolic engines handle Fin/Inf acceptance natively
+    		post.set_type(spot::postprocessor::Parity);
+    	}
     	ag_ = post.run(ag_, f_);
 
     	if (scc_optim_)
@@ -6,12 +6,15 @@
 #include <string>
 
 #include "sogtgba.hh"
+#include "sogcache.hh"
 #include <spot/misc/timer.hh>
 #include <spot/tl/formula.hh>
 #include <spot/tl/apcollect.hh>
 #include <spot/twa/bdddict.hh>
+#include <spot/twaalgos/emptiness.hh>
 
 #include "its/ITSModel.hh"
+#include "tgbaIts.hh"
 
 
 
@@ -44,6 +47,8 @@ namespace sogits {
     spot::twa_graph_ptr ag_;
     spot::twa_ptr a_;
     std::shared_ptr<sog_tgba> systgba_;
+    // optional on-disk cache of observation graphs, not owned
+    const sog_cache * sogCache_;
     // options
     std::string echeck_algo_;
     bool ce_expected_;
@@ -58,12 +63,42 @@ namespace sogits {
     bool print_formula_tgba_;
     bool isPlaceSyntax;
     bool stutter_dead_;
+    bool coi_;
+    bool fs_decision_;
+    bool fs_scc_;
+    its::TgbaType::encoding_t fs_encoding_;
+    bool fs_tgba_top_;
+    bool fs_parity_;
+    bool fs_stutter_;
+    bool fs_stats_;
+    bool fs_fixed_order_;
+    its::labels_t weak_fair_;
+    its::labels_t strong_fair_;
+    unsigned swarm_;
+    unsigned scc_parallel_;
 
     spot::timer_map timers;
 
     bool buildTgbaFromformula (sog_product_type sogtype);
 
-    bool fs_model_check(bool isOWCTY);
+    bool fs_model_check(sog_product_type sogtype);
+
+    // run the emptiness check in swarm_ forked processes, each exploring the product in its own order.
+    bool swarm_check(const spot::emptiness_check_instantiator_ptr & echeck_inst,
+		     const spot::const_twa_ptr & prod);
+
+    // explore the product by automaton SCC : each (SCC, entry aggregate) pair is checked by one of
+    // scc_parallel_ forked processes, which report the entries of further SCCs as paths from the initial state.
+    bool scc_parallel_check(const spot::emptiness_check_instantiator_ptr & echeck_inst,
+			    const spot::const_twa_ptr & prod);
+
+    // print the statistics and the verdict of an emptiness check, true if an accepting run exists.
+    bool report_check(const spot::emptiness_check_ptr & ec,
+		      const spot::emptiness_check_result_ptr & res);
+
+    // return the observation graph to use in the product : either systgba_, or
+    // its fully built counterpart loaded from (or stored into) the SOG cache.
+    spot::const_twa_ptr getObservationGraph (sog_product_type sogtype);
   public :
     LTLChecker () : sap_(nullptr),
 		    f_(nullptr),
@@ -72,6 +107,7 @@ namespace sogits {
 		    sogModel_(nullptr),
 		    a_(nullptr),
 		    systgba_(nullptr),
+		    sogCache_(nullptr),
 		    fm_exprop_opt_(false),
 		    fm_symb_merge_opt_(true),
 		    post_branching_(false),
@@ -82,7 +118,18 @@ namespace sogits {
 		    scc_optim_full_(false),
                     print_formula_tgba_(false),
 		    isPlaceSyntax(false),
-		    stutter_dead_(false){}
+		    stutter_dead_(false),
+		    coi_(false),
+		    fs_decision_(false),
+		    fs_scc_(false),
+		    fs_encoding_(its::TgbaType::INTEGER),
+		    fs_tgba_top_(true),
+		    fs_parity_(false),
+		    fs_stutter_(false),
+		    fs_stats_(false),
+		    fs_fixed_order_(false),
+		    swarm_(0),
+		    scc_parallel_(0){}
 
     ~LTLChecker();
 
@@ -97,11 +144,48 @@ namespace sogits {
       model_ = model;
     }
 
+    // Use an on-disk cache of observation graphs (for SOG and BCZ99 variants).
+    void setSogCache (const sog_cache * cache) { sogCache_ = cache; }
+
     // True if for ascending compatibility issues, atomic properties should be reinterpreted
     // as if they were just the names of places, instead of comparisons.
     // e.g. reinterpret AP  "Idle0" as "Idle0 = 1"
     void setPlaceSyntax (bool val) { isPlaceSyntax = val; }
 
+    // Slice the model to the cone of influence of the AP of the formula before checking.
+    void setConeOfInfluence (bool val) { coi_ = val; }
+
+    // Fully symbolic engines stop as soon as an accepting cycle is certain.
+    void setFsDecision (bool val) { fs_decision_ = val; }
+
+    // Fully symbolic engines work separately on each accepting SCC of the automaton.
+    void setFsSCC (bool val) { fs_scc_ = val; }
+
+    // Encoding of the automaton state, and its position above or below the model, in the fully symbolic product.
+    void setFsEncoding (its::TgbaType::encoding_t encoding) { fs_encoding_ = encoding; }
+    void setFsTgbaOnTop (bool val) { fs_tgba_top_ = val; }
+
+    // Translate the formula to a parity automaton for the fully symbolic engines.
+    void setFsParity (bool val) { fs_parity_ = val; }
+
+    // Fully symbolic engines saturate the model steps under automaton self loops.
+    void setFsStutter (bool val) { fs_stutter_ = val; }
+
+    // Fully symbolic engines print the statistics of their hulls.
+    void setFsStats (bool val) { fs_stats_ = val; }
+
+    // Fully symbolic hulls apply the acceptance closures in a fixed order, rather than the most effective first.
+    void setFsFixedOrder (bool val) { fs_fixed_order_ = val; }
+
+    // Model transitions, by name, under weak or strong fairness (fully symbolic engines and SLAP sub-check).
+    void setFairness (const its::labels_t & weak, const its::labels_t & strong) { weak_fair_ = weak; strong_fair_ = strong; }
+
+    // Run the explicit emptiness checks in this many processes, each with its own random exploration order.
+    void setSwarm (unsigned workers) { swarm_ = workers; }
+
+    // Check the SLAP and SOP products by automaton SCC, in this many processes.
+    void setSccParallel (unsigned workers) { scc_parallel_ = workers; }
+
     void setOptions (const std::string& echeck_algo,
 		     bool ce_expected,
 		     bool fm_exprop_opt=false,
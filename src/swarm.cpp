@@ -0,0 +1,49 @@
+#include "swarm.hh"
+
+#include <algorithm>
+
+namespace sogits {
+
+  stored_succ_iterator::~stored_succ_iterator () {
+    for (auto & succ : succs_) {
+      succ.dst->destroy();
+    }
+  }
+
+  swarm_twa::swarm_twa (const spot::const_twa_ptr & inner, unsigned seed)
+    : spot::twa(inner->get_dict()), inner_(inner), rng_(seed) {
+    copy_ap_of(inner);
+    copy_acceptance_of(inner);
+  }
+
+  spot::state* swarm_twa::get_init_state () const {
+    const spot::state * init = inner_->get_init_state();
+    spot::state * res = init->clone();
+    init->destroy();
+    return res;
+  }
+
+  spot::twa_succ_iterator* swarm_twa::succ_iter (const spot::state* local_state) const {
+    // the successors are all computed up front, then shuffled
+    std::vector<stored_succ_iterator::succ_t> succs;
+    spot::twa_succ_iterator * it = inner_->succ_iter(local_state);
+    for (it->first(); !it->done(); it->next()) {
+      succs.push_back({ it->dst(), it->cond(), it->acc() });
+    }
+    inner_->release_iter(it);
+    std::shuffle(succs.begin(), succs.end(), rng_);
+    return new stored_succ_iterator(std::move(succs));
+  }
+
+  std::string swarm_twa::format_state (const spot::state* state) const {
+    return inner_->format_state(state);
+  }
+
+  spot::state* swarm_twa::project_state (const spot::state* s,
+					 const spot::const_twa_ptr& t) const {
+    if (t.get() == this)
+      return s->clone();
+    return inner_->project_state(s, t);
+  }
+
+}
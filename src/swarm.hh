@@ -0,0 +1,64 @@
+#ifndef SOG_SWARM_HH
+#define SOG_SWARM_HH
+
+#include <random>
+#include <utility>
+#include <vector>
+
+#include <spot/twa/twa.hh>
+
+namespace sogits {
+
+  /// \brief Iterate over a list of successors computed up front.
+  class stored_succ_iterator : public spot::twa_succ_iterator
+  {
+  public :
+    struct succ_t {
+      const spot::state * dst;
+      bdd cond;
+      spot::acc_cond::mark_t acc;
+    };
+  private :
+    std::vector<succ_t> succs_;
+    size_t pos_;
+
+  public:
+    /// the iterator owns the destination states
+    stored_succ_iterator (std::vector<succ_t> && succs) : succs_(std::move(succs)), pos_(0) {}
+    virtual ~stored_succ_iterator ();
+
+    bool first () override { pos_ = 0; return ! done(); }
+    bool next () override { ++pos_; return ! done(); }
+    bool done () const override { return pos_ >= succs_.size(); }
+
+    const spot::state* dst () const override { return succs_[pos_].dst->clone(); }
+    bdd cond () const override { return succs_[pos_].cond; }
+    spot::acc_cond::mark_t acc () const override { return succs_[pos_].acc; }
+  };
+
+  /// \brief A view of a product whose successors are explored in a random order.
+  /// Used by the swarm emptiness check : each worker explores the same product
+  /// with its own permutation, so that one of them hopefully reaches a counterexample early.
+  class swarm_twa : public spot::twa
+  {
+    spot::const_twa_ptr inner_;
+    // the permutations are drawn from a generator seeded per worker
+    mutable std::mt19937 rng_;
+
+  public :
+    swarm_twa (const spot::const_twa_ptr & inner, unsigned seed);
+
+    virtual spot::state* get_init_state () const override;
+
+    virtual spot::twa_succ_iterator*
+    succ_iter (const spot::state* local_state) const override;
+
+    virtual std::string format_state (const spot::state* state) const override;
+
+    virtual spot::state* project_state (const spot::state* s,
+					const spot::const_twa_ptr& t) const override;
+  };
+
+}
+
+#endif
@@ -6,6 +6,9 @@
 #include <spot/misc/escape.hh>
 #include "ddd/Hom_Basic.hh"
 #include <sstream>
+#include <algorithm>
+#include <vector>
+#include <cstdlib>
 
 namespace its {
 
@@ -52,25 +55,243 @@ namespace its {
 			const spot::state* out_s, int out,
 			const spot::twa_succ_iterator* si)
       {
-	TgbaType::tgba_arc_label_t lab (si->cond(), si->acc());
-	TgbaType::tgba_arc_t arc (in,out);
-	TgbaType::arcs_it it = arcs_.find(lab);
+	bdd cond = si->cond();
+	TgbaType::tgba_arc_t arc (in, out, si->acc());
+	TgbaType::arcs_it it = arcs_.find(cond);
 	if ( it != arcs_.end() ) {
 	  // already some arcs matched to this key
 	  it->second.push_back(arc);
 	} else {
-	  arcs_.insert(TgbaType::arcs_t::value_type(lab, TgbaType::tgba_arcs_t(1,arc)));
+	  arcs_.insert(TgbaType::arcs_t::value_type(cond, TgbaType::tgba_arcs_t(1,arc)));
 	}
       }
 
     };
   }
 
-  TgbaType::TgbaType (const spot::const_twa_ptr& tgba) : tgba_(tgba)
+  TgbaType::TgbaType (const spot::const_twa_ptr& tgba, encoding_t encoding) : tgba_(tgba), encoding_(encoding), nbStates_(1)
   {
     loadTGBA::load_bfs b(tgba, arcs_);
     b.run();
+    for (arcs_it it = arcs_.begin() ; it != arcs_.end() ; ++it) {
+      for (tgba_arcs_it jt = it->second.begin() ; jt != it->second.end() ; ++jt) {
+	nbStates_ = std::max(nbStates_, std::max(jt->src, jt->dst));
+      }
+    }
+    switch (encoding_) {
+    case BINARY :
+      nbVars_ = 1;
+      while ((1 << nbVars_) <= nbStates_)
+	++nbVars_;
+      break;
+    case ONEHOT :
+      nbVars_ = nbStates_;
+      break;
+    case INTEGER :
+    default :
+      nbVars_ = 1;
+      break;
+    }
     build_labels();
+    build_sccs();
+  }
+
+  labels_t TgbaType::getVarSet () const {
+    if (encoding_ == INTEGER)
+      return labels_t (1,"state");
+    labels_t ret;
+    for (int var = nbVars_ - 1 ; var >= 0 ; --var) {
+      std::ostringstream os;
+      os << "state." << var;
+      ret.push_back(os.str());
+    }
+    return ret;
+  }
+
+  int TgbaType::getBit (int s, int var) const {
+    switch (encoding_) {
+    case BINARY :
+      return (s >> var) & 1;
+    case ONEHOT :
+      // variable var is set for state var+1
+      return (s == var + 1) ? 1 : 0;
+    case INTEGER :
+    default :
+      return s;
+    }
+  }
+
+  GDDD TgbaType::encodeState (int s) const {
+    GDDD d = GDDD::one;
+    for (int var = 0 ; var < nbVars_ ; ++var) {
+      d = GDDD(var, getBit(s, var), d);
+    }
+    return d;
+  }
+
+  GHom TgbaType::testState (int s) const {
+    GHom h = GHom::id;
+    for (int var = 0 ; var < nbVars_ ; ++var) {
+      h = varEqState(var, getBit(s, var)) & h;
+    }
+    return h;
+  }
+
+  GHom TgbaType::setState (int src, int dst) const {
+    // only write the variables that differ
+    GHom h = GHom::id;
+    for (int var = 0 ; var < nbVars_ ; ++var) {
+      int bit = getBit(dst, var);
+      if (bit != getBit(src, var))
+	h = setVarConst(var, bit) & h;
+    }
+    return h;
+  }
+
+  namespace loadTGBA
+  {
+    // Tarjan's SCC algorithm on the integer arcs of the automaton.
+    class scc_builder {
+      const std::vector<std::vector<int> > & succs_;
+      std::vector<int> & sccOf_;
+      std::vector<int> index_;
+      std::vector<int> low_;
+      std::vector<bool> onStack_;
+      std::vector<int> stack_;
+      int next_;
+      int nbScc_;
+    public :
+      scc_builder (const std::vector<std::vector<int> > & succs, std::vector<int> & sccOf)
+	: succs_(succs), sccOf_(sccOf), index_(succs.size(), -1), low_(succs.size(), 0),
+	  onStack_(succs.size(), false), next_(0), nbScc_(0) {
+	sccOf_.assign(succs.size(), -1);
+      }
+
+      int run () {
+	for (size_t s = 1 ; s < succs_.size() ; ++s) {
+	  if (index_[s] == -1)
+	    visit(s);
+	}
+	return nbScc_;
+      }
+
+    private :
+      void visit (int s) {
+	index_[s] = low_[s] = next_++;
+	stack_.push_back(s);
+	onStack_[s] = true;
+	for (int d : succs_[s]) {
+	  if (index_[d] == -1) {
+	    visit(d);
+	    low_[s] = std::min(low_[s], low_[d]);
+	  } else if (onStack_[d]) {
+	    low_[s] = std::min(low_[s], index_[d]);
+	  }
+	}
+	if (low_[s] == index_[s]) {
+	  int d;
+	  do {
+	    d = stack_.back();
+	    stack_.pop_back();
+	    onStack_[d] = false;
+	    sccOf_[d] = nbScc_;
+	  } while (d != s);
+	  ++nbScc_;
+	}
+      }
+    };
+  }
+
+  void TgbaType::build_sccs () {
+    // states are numbered from 1
+    std::vector<std::vector<int> > succs (nbStates_ + 1);
+    for (arcs_it it = arcs_.begin() ; it != arcs_.end() ; ++it) {
+      for (tgba_arcs_it jt = it->second.begin() ; jt != it->second.end() ; ++jt) {
+	succs[jt->src].push_back(jt->dst);
+      }
+    }
+    int nbScc = loadTGBA::scc_builder(succs, sccOf_).run();
+
+    // an SCC can accept if the union of the marks of its inner arcs can satisfy the condition
+    // (with Fin sets, this is an over approximation)
+    std::vector<bool> hasCycle (nbScc, false);
+    std::vector<spot::acc_cond::mark_t> marks (nbScc, spot::acc_cond::mark_t({}));
+    for (arcs_it it = arcs_.begin() ; it != arcs_.end() ; ++it) {
+      for (tgba_arcs_it jt = it->second.begin() ; jt != it->second.end() ; ++jt) {
+	int scc = sccOf_[jt->src];
+	if (scc == sccOf_[jt->dst]) {
+	  hasCycle[scc] = true;
+	  marks[scc] |= jt->acc;
+	}
+      }
+    }
+    sccAccepting_.assign(nbScc, false);
+    for (int scc = 0 ; scc < nbScc ; ++scc) {
+      sccAccepting_[scc] = hasCycle[scc] && tgba_->acc().inf_satisfiable(marks[scc]);
+    }
+  }
+
+  Transition TgbaType::getSuccsInSCC (const labels_t & tau, int scc) const {
+    Transition toret = GShom::id;
+    for (labels_it it = tau.begin() ; it != tau.end() ; ++it ) {
+      Transition inner = buildRestrictedTransition(*it, -1, scc);
+      if (inner == Transition::null)
+	return Transition::null;
+      toret = inner & toret;
+    }
+    return toret;
+  }
+
+  Transition TgbaType::getSuccsByAcc (Label trans, Label acc, int scc) const {
+    return buildRestrictedTransition(trans, atoi(acc.c_str()), scc);
+  }
+
+  Transition TgbaType::getSuccsAvoiding (Label trans, spot::acc_cond::mark_t avoid, Label acc) const {
+    return buildRestrictedTransition(trans, acc.empty() ? -1 : atoi(acc.c_str()), -1, avoid);
+  }
+
+  std::map<int, labels_t> TgbaType::getSelfLoops () const {
+    std::map<int, labels_t> loops;
+    for (labmap_t::const_iterator it = labmap_.begin() ; it != labmap_.end() ; ++it) {
+      arcs_t::const_iterator arcs = arcs_.find(it->second);
+      std::set<int> seen;
+      for (tgba_arcs_it jt = arcs->second.begin() ; jt != arcs->second.end() ; ++jt) {
+	// several loops with different acceptance share the label
+	if (jt->src == jt->dst && seen.insert(jt->src).second)
+	  loops[jt->src].push_back(it->first);
+      }
+    }
+    return loops;
+  }
+
+  Transition TgbaType::getSuccsWithoutSelfLoops (Label trans) const {
+    arcs_t::const_iterator it = arcs_.find(getTransLabelCondition(trans));
+    tgba_arcs_t kept;
+    for (tgba_arcs_it jt = it->second.begin() ; jt != it->second.end() ; ++jt) {
+      if (jt->src != jt->dst)
+	kept.push_back(*jt);
+    }
+    if (kept.empty())
+      return Transition::null;
+    return localApply(buildTransitionSet(kept), 0);
+  }
+
+  labels_t TgbaType::getTransLabelAcceptance (Label trans) const {
+    arcs_t::const_iterator it = arcs_.find(getTransLabelCondition(trans));
+    spot::acc_cond::mark_t acc = spot::acc_cond::mark_t({});
+    for (tgba_arcs_it jt = it->second.begin() ; jt != it->second.end() ; ++jt) {
+      acc |= jt->acc;
+    }
+    return getAcceptanceSet(acc);
+  }
+
+  Transition TgbaType::getSCCSelector (int scc) const {
+    std::set<GHom> sel;
+    for (size_t s = 1 ; s < sccOf_.size() ; ++s) {
+      if (sccOf_[s] == scc)
+	sel.insert(testState(s));
+    }
+    return localApply(GHom::add(sel), 0);
   }
 
   /** compute a vector of strings representing a bdd of an acceptance set */
@@ -111,13 +332,11 @@ namespace its {
     spot::escape_str(os, bdd_format_formula(tgba_->get_dict(), cond));
   }
 
-  /** A pretty print for tgba arc labels, wrapper that relies on print_acc and print_cond */
-  vLabel TgbaType::get_arc_label (const tgba_arc_label_t & lab) const {
+  /** A pretty print for tgba arc labels, relies on print_cond */
+  vLabel TgbaType::get_arc_label (bdd cond) const {
     std::stringstream os;
     os << "<" ;
-    print_cond(lab.first, os);
-    os << " , " ;
-    print_acc(lab.second, os);
+    print_cond(cond, os);
     os << ">";
     return os.str();
   }
@@ -131,14 +350,11 @@ namespace its {
 
   /** Build the transition for a structural arc */
   GHom TgbaType::buildTransition (const tgba_arc_t & arc) const {
-    /** an arc_t is simply a pair of integer */
-
     // test for self loop : optimizes away the write operation
-    if (arc.first == arc.second) {
-      // 0 is the DEFAULT_VAR
-      return varEqState(0, arc.first);
+    if (arc.src == arc.dst) {
+      return testState(arc.src);
     } else {
-      return setVarConst(0, arc.second) & varEqState(0, arc.first);
+      return setState(arc.src, arc.dst) & testState(arc.src);
     }
   }
 
@@ -154,9 +370,25 @@ namespace its {
   /** Build the its::Transition for a given string label */
   Transition TgbaType::buildTransitionFromLabel (Label label) const {
     // grab the appropriate arc set
-    tgba_arc_label_t tgbalab = getTransLabelDescription(label);
-    arcs_t::const_iterator it = arcs_.find(tgbalab);
+    arcs_t::const_iterator it = arcs_.find(getTransLabelCondition(label));
     return localApply(buildTransitionSet(it->second), 0);
   }
 
+  Transition TgbaType::buildRestrictedTransition (Label label, int acc, int scc, spot::acc_cond::mark_t avoid) const {
+    arcs_t::const_iterator it = arcs_.find(getTransLabelCondition(label));
+    tgba_arcs_t kept;
+    for (tgba_arcs_it jt = it->second.begin() ; jt != it->second.end() ; ++jt) {
+      if (acc >= 0 && ! jt->acc.has(acc))
+	continue;
+      if (jt->acc & avoid)
+	continue;
+      if (scc >= 0 && (sccOf_[jt->src] != scc || sccOf_[jt->dst] != scc))
+	continue;
+      kept.push_back(*jt);
+    }
+    if (kept.empty())
+      return Transition::null;
+    return localApply(buildTransitionSet(kept), 0);
+  }
+
 }
@@ -16,18 +16,38 @@ namespace its {
 /** Implement a type by adapting the TGBA interface.
  *  Using delegation to build a type from a TGBA */
   class TgbaType : public TypeBasics {
+  public :
+    /** How the automaton state is encoded in the DDD of this type :
+     *  INTEGER : a single variable holding the state number,
+     *  BINARY : one boolean variable per bit of the state number,
+     *  ONEHOT : one boolean variable per state, set to 1 for the current state. */
+    enum encoding_t { INTEGER, BINARY, ONEHOT };
+  private :
     // the concrete storage class
     spot::const_twa_ptr tgba_;
     // used to label SDD node of PNet.
     static const int DEFAULT_VAR = 0;
     // used to name this type
     static const std::string name_ ;
+    // the state encoding
+    encoding_t encoding_;
+    // the number of states of the automaton, numbered from 1
+    int nbStates_;
+    // the number of DDD variables used by the encoding
+    int nbVars_;
+
+    /** The value of DDD variable var in the encoding of state s */
+    int getBit (int s, int var) const;
+    /** The DDD encoding of state s */
+    GDDD encodeState (int s) const;
+    /** A Hom that selects the encoding of state s */
+    GHom testState (int s) const;
+    /** A Hom that overwrites the encoding of state src by the one of state dst */
+    GHom setState (int src, int dst) const;
   protected :
-    virtual labels_t getVarSet () const {
-      return labels_t (1,"state");
-    }
+    virtual labels_t getVarSet () const;
   public :
-    TgbaType (const spot::const_twa_ptr& tgba_) ;
+    TgbaType (const spot::const_twa_ptr& tgba_, encoding_t encoding = INTEGER) ;
 
     /** Allow to visit the underlying type definition */
     void visit (class TypeVisitor * visitor) const {
@@ -48,10 +68,13 @@ namespace its {
       return labels_t(1,"init");
     }
 
-    /** the type that designates a TGBA arc label : <apcond , acc> as a pair of bdd */
-    typedef std::pair<bdd, spot::acc_cond::mark_t> tgba_arc_label_t;
-    /** the type that designates a physical arc description : <source, target> as a pair of integer */
-    typedef std::pair<int,int> tgba_arc_t;
+    /** the type that designates a physical arc description : <source, target, acceptance marks> */
+    struct tgba_arc_t {
+      int src;
+      int dst;
+      spot::acc_cond::mark_t acc;
+      tgba_arc_t (int s, int d, spot::acc_cond::mark_t a) : src(s), dst(d), acc(a) {}
+    };
 
 
     /** a data structure to store a set of physical arc descriptions */
@@ -59,16 +82,10 @@ namespace its {
     typedef tgba_arcs_t::const_iterator tgba_arcs_it;
 
 
-    struct less_than {
-      bool operator()(const its::TgbaType::tgba_arc_label_t &g1, const its::TgbaType::tgba_arc_label_t &g2) const{
-	return g1.first.id() < g2.first.id()
-	  || ( (! (g1.first.id() > g2.first.id() )) && g1.second < g2.second);
-      }
-    };
-
-
-    /** a data structure to store mappings of TGBA arc label to physical arcs that bear this label */
-    typedef std::map<tgba_arc_label_t,tgba_arcs_t,less_than> arcs_t;
+    /** a data structure to store mappings of TGBA arc condition to physical arcs that bear this condition.
+     *  Arcs with the same condition but different acceptance share an entry, so that the model side
+     *  of the product is built once per condition. */
+    typedef std::map<bdd,tgba_arcs_t,spot::bdd_less_than> arcs_t;
     typedef arcs_t::iterator arcs_it;
 
   private :
@@ -79,27 +96,39 @@ namespace its {
     void print_acc(spot::acc_cond::mark_t acc, std::ostream & os) const;
     /** A helper function to print the atomic prop condition formula bdd */
     void print_cond(bdd cond, std::ostream & os) const;
-    /** A pretty print for tgba arc labels, wrapper that relies on print_acc and print_cond */
-    vLabel get_arc_label (const tgba_arc_label_t & lab) const;
+    /** A pretty print for tgba arc labels, relies on print_cond */
+    vLabel get_arc_label (bdd cond) const;
 
 
-    /** A map to store string label to tgba_arc_label correspondance */
-    typedef std::map<vLabel, tgba_arc_label_t> labmap_t;
+    /** A map to store string label to arc condition correspondance */
+    typedef std::map<vLabel, bdd> labmap_t;
     typedef labmap_t::iterator labmap_it;
     labmap_t labmap_;
 
     /** build the string labels and fill labmap */
     void build_labels();
 
+    /** the automaton SCC index of each state, indexed by state number (states are numbered from 1) */
+    std::vector<int> sccOf_;
+    /** for each automaton SCC, true if a cycle inside it can be accepting */
+    std::vector<bool> sccAccepting_;
+    /** compute sccOf_ and sccAccepting_ from the arcs */
+    void build_sccs();
+
     /** Build the transition for a structural arc */
     GHom buildTransition (const tgba_arc_t & arc) const;
     /** Build the Hom for a set of structural arcs */
     GHom buildTransitionSet (const tgba_arcs_t & arcs) const;
     /** Build the its::Transition for a given string label */
     Transition buildTransitionFromLabel (Label label) const;
+    /** Build the its::Transition for the arcs of a given string label that bear acceptance set acc (any if acc < 0),
+     *  lie inside automaton SCC scc (any if scc < 0) and bear none of the sets in avoid.
+     *  Returns Transition::null if no arc is kept. */
+    Transition buildRestrictedTransition (Label label, int acc, int scc,
+					  spot::acc_cond::mark_t avoid = spot::acc_cond::mark_t({})) const;
   public :
 
-    /** the set T of public transition labels : one for each distinct AP formula x acceptance set labeling the tgba arcs*/
+    /** the set T of public transition labels : one for each distinct AP formula labeling the tgba arcs*/
     labels_t getTransLabels () const {
       labels_t ret;
       for (labmap_t::const_iterator it = labmap_.begin() ; it != labmap_.end() ; ++it) {
@@ -111,10 +140,8 @@ namespace its {
     /** compute a vector of strings representing an acceptance mark */
     static labels_t getAcceptanceSet (spot::acc_cond::mark_t acc);
 
-    tgba_arc_label_t getTransLabelDescription (Label trans) const {
-      // example : trans = "a . !b x {}" => bdd of : a.!b,  empty set of acc
-      // example : trans = "a  x {black,white}" => bdd of : a,  set of acc {black,white}
-
+    /** the AP condition of a transition label */
+    bdd getTransLabelCondition (Label trans) const {
       labmap_t::const_iterator it = labmap_.find(trans);
       if (it == labmap_.end()) {
 	std::cerr << "asked for unknown label : "<< trans << " in a TgbaIts Type" << std::endl;
@@ -124,6 +151,9 @@ namespace its {
       return it->second;
     }
 
+    /** the acceptance sets borne by at least one arc of a transition label */
+    labels_t getTransLabelAcceptance (Label trans) const;
+
 
     /** state and transitions representation functions */
     /** Local transitions : none, all transitions are synchronizable */
@@ -144,12 +174,56 @@ namespace its {
       return toret;
     }
 
+    /** The number of SCC of the automaton, including trivial ones. */
+    int getSCCCount () const {
+      return sccAccepting_.size();
+    }
+
+    /** True if the automaton SCC scc contains a cycle that visits all acceptance sets. */
+    bool isAcceptingSCC (int scc) const {
+      return sccAccepting_[scc];
+    }
+
+    /** Same as getSuccs, but only arcs with both ends in the automaton SCC scc are kept.
+     *  Returns Transition::null if no arc remains. */
+    Transition getSuccsInSCC (const labels_t & tau, int scc) const;
+
+    /** The arcs of label trans that bear acceptance set acc (as returned by getAcceptanceSet),
+     *  restricted to automaton SCC scc if scc is not negative.
+     *  Returns Transition::null if no arc remains. */
+    Transition getSuccsByAcc (Label trans, Label acc, int scc = -1) const;
+
+    /** The arcs of label trans that bear none of the sets in avoid, and bear acceptance set acc if it is not empty.
+     *  Used to restrict the product to one clause of a Fin/Inf acceptance condition.
+     *  Returns Transition::null if no arc remains. */
+    Transition getSuccsAvoiding (Label trans, spot::acc_cond::mark_t avoid, Label acc = "") const;
+
+    /** For each automaton state that has self loops, the labels of its self loops. */
+    std::map<int, labels_t> getSelfLoops () const;
+
+    /** Same as getSuccs for a single label, without the self loop arcs.
+     *  Returns Transition::null if no arc remains. */
+    Transition getSuccsWithoutSelfLoops (Label trans) const;
+
+    /** Select the encoding of automaton state s. */
+    Transition getStateSelector (int s) const {
+      return localApply(testState(s), 0);
+    }
+
+    /** The acceptance condition of the automaton. */
+    const spot::acc_cond & getAcceptance () const {
+      return tgba_->acc();
+    }
+
+    /** Select the states of the automaton that belong to SCC scc. */
+    Transition getSCCSelector (int scc) const;
+
     /** To obtain a representation of a labeled state */
     State getState(Label stateLabel) const {
       // only one initial state
       assert (stateLabel == "init");
       // the initial state has id 1 by definition
-      return State(DEFAULT_VAR, DDD(0, 1 ));
+      return State(DEFAULT_VAR, DDD(encodeState(1)));
     }
 
     State getPotentialStates (State reachable) const {
@@ -166,17 +240,19 @@ namespace its {
       os << "Internal view (arcs):" << std::endl;
       for (arcs_t::const_iterator it = arcs_.begin() ; it != arcs_.end() ; ++it ) {
 	os << get_arc_label(it->first);
-	os << it->first.first.id() << "/" << it->first.second << "  ";
+	os << it->first.id() << "  ";
 	os << "   : ";
 	for (tgba_arcs_it jt = it->second.begin() ; jt != it->second.end() ; ++jt) {
-	  os << jt->first << "->" << jt->second << " ;" ;
+	  os << jt->src << "->" << jt->dst << " ";
+	  print_acc(jt->acc, os);
+	  os << " ;" ;
 	}
 	os << std::endl;
       }
       os << "Internal view (labmap):" << std::endl;
       for (labmap_t::const_iterator it = labmap_.begin() ; it != labmap_.end() ; ++it) {
 	os << it->first << " mapsto " << get_arc_label(it->second) << "  ";
-	os << it->second.first.id() << "/" << it->second.second << "  ";
+	os << it->second.id() << "  ";
 	os << std::endl;
       }
       os << std::endl;